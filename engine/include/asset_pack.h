@@ -0,0 +1,40 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+
+// Binary pack of pre-decoded RGBA32 images, written offline by engine/tools/packer
+// and memory-mapped at startup.
+//
+// Layout: AssetPackHeader, entry_count AssetPackEntry records, then pixel data.
+// Each image's rows are tightly packed (pitch = width * 4) at a 16-byte aligned offset.
+
+#define ASSET_PACK_MAGIC 0x4B415041u // "APAK"
+#define ASSET_PACK_VERSION 2
+#define ASSET_PACK_NAME_LENGTH 64
+#define ASSET_PACK_PATH "engine/assets/assets.pack"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+} AssetPackHeader;
+
+typedef struct {
+    char name[ASSET_PACK_NAME_LENGTH]; // image file name, e.g. "player.png"
+    uint32_t width, height;
+    uint32_t pitch;
+    uint32_t reserved;
+    uint64_t offset; // from start of file
+    uint64_t size;
+    int64_t source_mtime; // modification time and size of the PNG when it was packed;
+    uint64_t source_size; // entries whose source has changed since are skipped
+} AssetPackEntry;
+
+int asset_pack_open(const char *path);
+void asset_pack_close();
+SDL_Surface *asset_pack_surface(const char *filepath);
+
+#endif
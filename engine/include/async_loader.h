@@ -0,0 +1,24 @@
+#ifndef ASYNC_LOADER_H
+#define ASYNC_LOADER_H
+
+#include <SDL2/SDL.h>
+
+#define ASYNC_LOADER_MAX_THREADS 4
+#define ASYNC_PATH_LENGTH 256
+
+// A decoded image waiting for its main-thread upload
+typedef struct {
+    int sprite_id;
+    int builtin; // bake the procedural sprite if decoding failed
+    SDL_Surface *surface; // NULL if decoding failed
+    char filepath[ASYNC_PATH_LENGTH];
+} AsyncLoadResult;
+
+void async_loader_init();
+void async_loader_shutdown();
+int async_loader_enqueue(int sprite_id, const char *filepath, int builtin);
+int async_loader_poll(AsyncLoadResult *out);
+int async_loader_wait(AsyncLoadResult *out);
+int async_loader_pending();
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <SDL2/SDL.h>
+
+#define ATLAS_PAGE_SIZE 2048
+#define MAX_ATLAS_PAGES 4
+#define ATLAS_PADDING 1 // empty pixels between packed images
+
+typedef struct {
+    int page;     // atlas page index, -1 if not packed
+    SDL_Rect src; // source rect within the page
+} AtlasSprite;
+
+void atlas_init(SDL_Renderer *renderer);
+int atlas_add_surface(SDL_Surface *surface, AtlasSprite *out);
+SDL_Texture *atlas_page_texture(int page);
+int atlas_page_count();
+void atlas_clear();
+
+#endif
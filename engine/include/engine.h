@@ -6,6 +6,8 @@
 #include "levels.h"
 
 #define MAX_TEXTURES 100
+#define RENDER_QUEUE_INITIAL_CAPACITY 8192
+#define ASYNC_UPLOAD_BUDGET_MS 2.0f // per-frame time spent uploading decoded textures
 
 typedef struct {
     float x, y;  // position
@@ -15,6 +17,12 @@ typedef struct {
     int layer; // for layering
 } RenderCommand;
 
+typedef struct {
+    int world_submitted; // commands passed to engine_submit_world
+    int world_culled;    // of those, rejected by the view rect
+    int drawn;           // commands flushed to the renderer
+} RenderStats;
+
 typedef struct {
     float x, y;
     float target_x, target_y;
@@ -25,11 +33,18 @@ typedef struct {
 void engine_init(SDL_Renderer *renderer);
 void engine_begin_frame();
 void engine_submit(RenderCommand cmd);
+int engine_submit_world(Camera *camera, const RenderCommand *cmds, int count);
+void engine_get_render_stats(RenderStats *stats);
 void engine_end_frame();
 void engine_shutdown();
 
 int engine_load_texture(const char* filepath);
+int engine_load_texture_async(const char* filepath);
+int engine_texture_ready(int sprite_id);
+void engine_process_async_loads(float budget_ms);
+void engine_wait_for_async_loads();
 void engine_unload_all_textures();
+void engine_get_sprite_size(int sprite_id, int *width, int *height);
 
 void camera_init(Camera* camera, int screen_width, int screen_height);
 void camera_follow(Camera* camera, float target_x, float target_y);
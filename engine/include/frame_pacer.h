@@ -0,0 +1,38 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <SDL2/SDL.h>
+
+#define FRAME_STATS_WINDOW 240   // frames kept for jitter statistics
+#define FRAME_PACER_SPIN_MS 2.0  // tail of each wait spent spinning instead of sleeping
+
+typedef enum {
+    FRAME_PACE_TARGET_FPS, // coarse sleep then spin up to a fixed frame deadline
+    FRAME_PACE_VSYNC,      // SDL_RenderPresent blocks on vblank, no extra waiting
+    FRAME_PACE_UNCAPPED    // no waiting at all, for benchmarking
+} FramePaceMode;
+
+typedef struct {
+    double mean_ms;
+    double stddev_ms; // jitter
+    double min_ms, max_ms;
+    int samples;
+} FrameStats;
+
+typedef struct {
+    FramePaceMode mode;
+    double target_fps;
+    Uint64 frequency;
+    Uint64 frame_ticks;   // target frame length in performance counter ticks
+    Uint64 next_deadline;
+    Uint64 last_frame_end;
+    float history_ms[FRAME_STATS_WINDOW];
+    int history_count;
+    int history_index;
+} FramePacer;
+
+void frame_pacer_init(FramePacer *pacer, SDL_Renderer *renderer, FramePaceMode mode, double target_fps);
+void frame_pacer_wait(FramePacer *pacer);
+void frame_pacer_get_stats(const FramePacer *pacer, FrameStats *stats);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <SDL2/SDL.h>
+
+// Worker threads with one work-stealing deque each. Owners push and pop at the back,
+// idle workers steal from the front. Threads that aren't workers get a deque of their
+// own the first time they submit. Anyone waiting on a counter runs queued jobs before
+// blocking: workers run anything, other threads only what they submitted themselves.
+
+#define JOB_SYSTEM_MAX_WORKERS 64
+#define JOB_SYSTEM_MAX_SUBMITTERS 8 // threads other than workers with their own deque; more run jobs inline
+#define JOB_QUEUE_SIZE 4096 // per deque, power of two; a full deque runs jobs inline
+
+// Runs over [begin, end)
+typedef void (*JobFunc)(void *userdata, int begin, int end);
+
+// Outstanding jobs of one batch; zero-initialise, then wait on it after submitting
+typedef struct {
+    SDL_atomic_t pending;
+} JobCounter;
+
+void job_system_init(int worker_count);
+void job_system_shutdown();
+int job_system_thread_count();
+void job_system_set_deterministic(int enabled);
+int job_system_is_deterministic();
+
+void job_submit(JobFunc func, void *userdata, int begin, int end, JobCounter *counter);
+void job_wait(JobCounter *counter);
+void job_parallel_for(int count, int grain, JobFunc func, void *userdata);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <SDL2/SDL.h>
+#include "engine.h"
+#include "levels.h"
+
+#define TILE_CHUNK_SIZE 32  // tiles per chunk side
+#define TILE_CACHE_SLOTS 32 // chunk render targets kept resident
+
+typedef struct {
+    SDL_Texture *texture;
+    int chunk_x, chunk_y; // chunk held by this slot, -1 when free
+    Uint32 last_used;     // frame stamp for LRU eviction
+} TileChunkSlot;
+
+typedef struct {
+    Map *map;
+    int chunks_w, chunks_h;
+    int margin;          // tiles whose sprites spill into a neighbouring chunk
+    uint8_t *dirty;      // per chunk, set when a cell inside (or within margin) changes
+    int *slot_of_chunk;  // per chunk, resident slot or -1
+    TileChunkSlot slots[TILE_CACHE_SLOTS];
+    Uint32 frame;
+    int use_targets;     // 0 when the renderer can't render to textures
+} TileCache;
+
+TileCache *tile_cache_create(Map *map);
+void tile_cache_destroy(TileCache *cache);
+int tile_cache_set_map(TileCache *cache, Map *map);
+void tile_cache_mark_dirty(TileCache *cache, int tile_x, int tile_y);
+void tile_cache_invalidate_all(TileCache *cache);
+void tile_cache_submit(TileCache *cache, Camera *camera, int layer);
+
+#endif
@@ -0,0 +1,151 @@
+#include "asset_pack.h"
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <stdlib.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static const uint8_t *pack_data = NULL;
+static size_t pack_size = 0;
+static const AssetPackEntry *pack_entries = NULL;
+static uint32_t pack_entry_count = 0;
+
+static int map_file(const char *path)
+{
+#ifdef _WIN32
+    // No mmap here, read the pack in one go instead
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = malloc(size);
+    if (!data || fread(data, 1, size, file) != (size_t)size)
+    {
+        free(data);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    pack_data = data;
+    pack_size = size;
+    return 0;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return -1;
+
+    pack_data = data;
+    pack_size = st.st_size;
+    return 0;
+#endif
+}
+
+static void unmap_file()
+{
+    if (!pack_data)
+        return;
+#ifdef _WIN32
+    free((void *)pack_data);
+#else
+    munmap((void *)pack_data, pack_size);
+#endif
+    pack_data = NULL;
+    pack_size = 0;
+}
+
+int asset_pack_open(const char *path)
+{
+    asset_pack_close();
+
+    if (map_file(path) != 0)
+        return -1;
+
+    const AssetPackHeader *header = (const AssetPackHeader *)pack_data;
+    if (pack_size < sizeof(AssetPackHeader) || header->magic != ASSET_PACK_MAGIC ||
+        header->version != ASSET_PACK_VERSION ||
+        pack_size < sizeof(AssetPackHeader) + (size_t)header->entry_count * sizeof(AssetPackEntry))
+    {
+        printf("Asset pack %s is invalid or out of date, ignoring it\n", path);
+        unmap_file();
+        return -1;
+    }
+
+    pack_entries = (const AssetPackEntry *)(pack_data + sizeof(AssetPackHeader));
+    pack_entry_count = header->entry_count;
+
+    // Reject entries pointing outside the file
+    for (uint32_t i = 0; i < pack_entry_count; i++)
+    {
+        const AssetPackEntry *entry = &pack_entries[i];
+        if (entry->offset > pack_size || entry->size > pack_size - entry->offset ||
+            (uint64_t)entry->pitch * entry->height > entry->size || entry->pitch < entry->width * 4)
+        {
+            printf("Asset pack %s is corrupt, ignoring it\n", path);
+            asset_pack_close();
+            return -1;
+        }
+    }
+
+    printf("Mapped asset pack %s (%u images)\n", path, pack_entry_count);
+    return 0;
+}
+
+void asset_pack_close()
+{
+    unmap_file();
+    pack_entries = NULL;
+    pack_entry_count = 0;
+}
+
+// Look up an image by the file name part of its path. The returned surface points
+// straight at the mapped pixels and must be freed (which leaves the pack untouched).
+// Returns NULL when the image on disk was edited after packing, so the caller loads
+// the fresh PNG instead; a missing PNG is fine, the pack may ship without sources.
+SDL_Surface *asset_pack_surface(const char *filepath)
+{
+    if (!pack_entries)
+        return NULL;
+
+    const char *name = strrchr(filepath, '/');
+    name = name ? name + 1 : filepath;
+
+    for (uint32_t i = 0; i < pack_entry_count; i++)
+    {
+        const AssetPackEntry *entry = &pack_entries[i];
+        if (strncmp(entry->name, name, ASSET_PACK_NAME_LENGTH) != 0)
+            continue;
+
+        struct stat st;
+        if (stat(filepath, &st) == 0 &&
+            ((int64_t)st.st_mtime != entry->source_mtime || (uint64_t)st.st_size != entry->source_size))
+        {
+            printf("Asset pack entry for %s is stale, loading the image instead\n", filepath);
+            return NULL;
+        }
+
+        return SDL_CreateRGBSurfaceWithFormatFrom((void *)(pack_data + entry->offset), entry->width, entry->height,
+                                                  32, entry->pitch, SDL_PIXELFORMAT_RGBA32);
+    }
+    return NULL;
+}
@@ -0,0 +1,201 @@
+#include "async_loader.h"
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ASYNC_QUEUE_SIZE 256
+
+typedef struct {
+    int sprite_id;
+    int builtin;
+    char filepath[ASYNC_PATH_LENGTH];
+} AsyncLoadRequest;
+
+static SDL_Thread *workers[ASYNC_LOADER_MAX_THREADS];
+static int worker_count = 0;
+static SDL_mutex *queue_mutex = NULL;
+static SDL_cond *request_cond = NULL;
+static SDL_cond *result_cond = NULL;
+static int stopping = 0;
+
+// Ring buffers, both guarded by queue_mutex
+static AsyncLoadRequest requests[ASYNC_QUEUE_SIZE];
+static int request_head = 0, request_count = 0;
+static AsyncLoadResult results[ASYNC_QUEUE_SIZE];
+static int result_head = 0, result_count = 0;
+
+static int pending = 0; // enqueued but not yet handed back through a pop
+
+static int worker_main(void *data)
+{
+    (void)data;
+
+    SDL_LockMutex(queue_mutex);
+    while (1)
+    {
+        while (request_count == 0 && !stopping)
+            SDL_CondWait(request_cond, queue_mutex);
+        if (stopping)
+            break;
+
+        AsyncLoadRequest request = requests[request_head];
+        request_head = (request_head + 1) % ASYNC_QUEUE_SIZE;
+        request_count--;
+        SDL_UnlockMutex(queue_mutex);
+
+        // Decode off the main thread; the upload to the renderer happens on the main thread
+        AsyncLoadResult result;
+        result.sprite_id = request.sprite_id;
+        result.builtin = request.builtin;
+        memcpy(result.filepath, request.filepath, ASYNC_PATH_LENGTH);
+        result.surface = IMG_Load(request.filepath);
+        if (!result.surface)
+        {
+            printf("Unable to load image %s! SDL_image Error: %s\n", request.filepath, IMG_GetError());
+        }
+
+        SDL_LockMutex(queue_mutex);
+        // The result ring can't overflow: it holds at most as many entries as were enqueued
+        results[(result_head + result_count) % ASYNC_QUEUE_SIZE] = result;
+        result_count++;
+        SDL_CondSignal(result_cond);
+    }
+    SDL_UnlockMutex(queue_mutex);
+    return 0;
+}
+
+void async_loader_init()
+{
+    queue_mutex = SDL_CreateMutex();
+    request_cond = SDL_CreateCond();
+    result_cond = SDL_CreateCond();
+    stopping = 0;
+    request_head = request_count = 0;
+    result_head = result_count = 0;
+    pending = 0;
+
+    // One decoder per core (capped) so startup takes as long as the slowest image, not the sum
+    int threads = SDL_GetCPUCount();
+    if (threads > ASYNC_LOADER_MAX_THREADS)
+        threads = ASYNC_LOADER_MAX_THREADS;
+    if (threads < 1)
+        threads = 1;
+
+    worker_count = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        workers[worker_count] = SDL_CreateThread(worker_main, "texture_decode", NULL);
+        if (!workers[worker_count])
+        {
+            printf("Unable to start texture decode thread! SDL Error: %s\n", SDL_GetError());
+            break;
+        }
+        worker_count++;
+    }
+}
+
+void async_loader_shutdown()
+{
+    if (!queue_mutex)
+        return;
+
+    SDL_LockMutex(queue_mutex);
+    stopping = 1;
+    SDL_CondBroadcast(request_cond);
+    SDL_UnlockMutex(queue_mutex);
+
+    for (int i = 0; i < worker_count; i++)
+    {
+        SDL_WaitThread(workers[i], NULL);
+    }
+    worker_count = 0;
+
+    // Drop anything decoded but never uploaded
+    while (result_count > 0)
+    {
+        if (results[result_head].surface)
+            SDL_FreeSurface(results[result_head].surface);
+        result_head = (result_head + 1) % ASYNC_QUEUE_SIZE;
+        result_count--;
+    }
+
+    SDL_DestroyCond(request_cond);
+    SDL_DestroyCond(result_cond);
+    SDL_DestroyMutex(queue_mutex);
+    request_cond = NULL;
+    result_cond = NULL;
+    queue_mutex = NULL;
+}
+
+int async_loader_enqueue(int sprite_id, const char *filepath, int builtin)
+{
+    if (strlen(filepath) >= ASYNC_PATH_LENGTH)
+    {
+        printf("Texture path too long: %s\n", filepath);
+        return -1;
+    }
+
+    SDL_LockMutex(queue_mutex);
+    if (worker_count == 0 || pending >= ASYNC_QUEUE_SIZE)
+    {
+        SDL_UnlockMutex(queue_mutex);
+        return -1;
+    }
+
+    AsyncLoadRequest *request = &requests[(request_head + request_count) % ASYNC_QUEUE_SIZE];
+    request->sprite_id = sprite_id;
+    request->builtin = builtin;
+    strcpy(request->filepath, filepath);
+    request_count++;
+    pending++;
+    SDL_CondSignal(request_cond);
+    SDL_UnlockMutex(queue_mutex);
+    return 0;
+}
+
+static int pop_result_locked(AsyncLoadResult *out)
+{
+    if (result_count == 0)
+        return 0;
+
+    *out = results[result_head];
+    result_head = (result_head + 1) % ASYNC_QUEUE_SIZE;
+    result_count--;
+    pending--;
+    return 1;
+}
+
+int async_loader_poll(AsyncLoadResult *out)
+{
+    if (!queue_mutex)
+        return 0;
+
+    SDL_LockMutex(queue_mutex);
+    int popped = pop_result_locked(out);
+    SDL_UnlockMutex(queue_mutex);
+    return popped;
+}
+
+int async_loader_wait(AsyncLoadResult *out)
+{
+    if (!queue_mutex)
+        return 0;
+
+    SDL_LockMutex(queue_mutex);
+    while (result_count == 0 && pending > 0)
+        SDL_CondWait(result_cond, queue_mutex);
+    int popped = pop_result_locked(out);
+    SDL_UnlockMutex(queue_mutex);
+    return popped;
+}
+
+int async_loader_pending()
+{
+    if (!queue_mutex)
+        return 0;
+
+    SDL_LockMutex(queue_mutex);
+    int count = pending;
+    SDL_UnlockMutex(queue_mutex);
+    return count;
+}
@@ -0,0 +1,157 @@
+#include "atlas.h"
+#include <stdio.h>
+
+// Shelf packer state for one atlas page
+typedef struct {
+    SDL_Texture *texture;
+    int cursor_x, cursor_y;
+    int shelf_height;
+} AtlasPage;
+
+static SDL_Renderer *atlas_renderer = NULL;
+static AtlasPage pages[MAX_ATLAS_PAGES];
+static int page_count = 0;
+
+void atlas_init(SDL_Renderer *renderer)
+{
+    atlas_renderer = renderer;
+    for (int i = 0; i < MAX_ATLAS_PAGES; i++)
+    {
+        pages[i].texture = NULL;
+    }
+    page_count = 0;
+}
+
+static int add_page()
+{
+    if (page_count >= MAX_ATLAS_PAGES)
+    {
+        printf("Cannot create more atlas pages, max reached!\n");
+        return -1;
+    }
+
+    SDL_Texture *texture = SDL_CreateTexture(atlas_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                                             ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+    if (!texture)
+    {
+        printf("Unable to create atlas page! SDL Error: %s\n", SDL_GetError());
+        return -1;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    AtlasPage *page = &pages[page_count];
+    page->texture = texture;
+    page->cursor_x = 0;
+    page->cursor_y = 0;
+    page->shelf_height = 0;
+    return page_count++;
+}
+
+// Try to reserve a w x h slot on a page, moving to a new shelf when the row is full.
+// The page is only touched on success, so a failed fit keeps the rest of the shelf.
+static int reserve_slot(AtlasPage *page, int w, int h, SDL_Rect *out)
+{
+    int padded_w = w + ATLAS_PADDING;
+    int padded_h = h + ATLAS_PADDING;
+
+    int cursor_x = page->cursor_x;
+    int cursor_y = page->cursor_y;
+    int shelf_height = page->shelf_height;
+    if (cursor_x + padded_w > ATLAS_PAGE_SIZE)
+    {
+        cursor_x = 0;
+        cursor_y += shelf_height;
+        shelf_height = 0;
+    }
+
+    if (cursor_y + padded_h > ATLAS_PAGE_SIZE)
+        return 0;
+
+    out->x = cursor_x;
+    out->y = cursor_y;
+    out->w = w;
+    out->h = h;
+
+    page->cursor_x = cursor_x + padded_w;
+    page->cursor_y = cursor_y;
+    page->shelf_height = padded_h > shelf_height ? padded_h : shelf_height;
+    return 1;
+}
+
+int atlas_add_surface(SDL_Surface *surface, AtlasSprite *out)
+{
+    if (surface->w + ATLAS_PADDING > ATLAS_PAGE_SIZE || surface->h + ATLAS_PADDING > ATLAS_PAGE_SIZE)
+    {
+        printf("Image of %dx%d does not fit in an atlas page!\n", surface->w, surface->h);
+        return -1;
+    }
+
+    // Find a page with room, starting a new one if all are full
+    int page_index = -1;
+    SDL_Rect slot;
+    for (int i = 0; i < page_count; i++)
+    {
+        if (reserve_slot(&pages[i], surface->w, surface->h, &slot))
+        {
+            page_index = i;
+            break;
+        }
+    }
+    if (page_index < 0)
+    {
+        page_index = add_page();
+        if (page_index < 0 || !reserve_slot(&pages[page_index], surface->w, surface->h, &slot))
+            return -1;
+    }
+
+    // Upload pixels into the reserved sub-rect
+    SDL_Surface *converted = surface;
+    if (surface->format->format != SDL_PIXELFORMAT_RGBA32)
+    {
+        converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+        if (!converted)
+        {
+            printf("Unable to convert image for atlas! SDL Error: %s\n", SDL_GetError());
+            return -1;
+        }
+    }
+
+    // On failure the slot stays reserved but unused; the caller falls back
+    int uploaded = SDL_UpdateTexture(pages[page_index].texture, &slot, converted->pixels, converted->pitch) == 0;
+    if (!uploaded)
+        printf("Unable to upload image to atlas! SDL Error: %s\n", SDL_GetError());
+
+    if (converted != surface)
+        SDL_FreeSurface(converted);
+    if (!uploaded)
+        return -1;
+
+    out->page = page_index;
+    out->src = slot;
+    return 0;
+}
+
+SDL_Texture *atlas_page_texture(int page)
+{
+    if (page < 0 || page >= page_count)
+        return NULL;
+    return pages[page].texture;
+}
+
+int atlas_page_count()
+{
+    return page_count;
+}
+
+void atlas_clear()
+{
+    for (int i = 0; i < page_count; i++)
+    {
+        if (pages[i].texture)
+        {
+            SDL_DestroyTexture(pages[i].texture);
+            pages[i].texture = NULL;
+        }
+    }
+    page_count = 0;
+}
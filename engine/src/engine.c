@@ -1,11 +1,48 @@
 #include "engine.h"
 #include "levels.h"
+#include "atlas.h"
+#include "engine_internal.h"
+#include "async_loader.h"
+#include "asset_pack.h"
+#include "job_system.h"
 #include <SDL2/SDL_image.h>
 #include <math.h>
 
 static SDL_Renderer *sdl_renderer = NULL;
-static SDL_Texture *textures[MAX_TEXTURES];
+static AtlasSprite sprites[MAX_TEXTURES]; // sprite_id -> atlas page + source rect
 static int texture_count = 0;
+static AtlasSprite missing_sprite = {-1, {0, 0, 32, 32}}; // drawn for unknown sprite_ids
+
+// Per-frame command buffer, sorted and flushed in engine_end_frame()
+typedef struct {
+    RenderCommand cmd;
+    SDL_Texture *texture; // resolved at submit time
+    SDL_Rect src;
+    int order; // submission order, keeps the sort stable
+} QueuedCommand;
+
+static QueuedCommand *render_queue = NULL;
+static int render_queue_count = 0;
+static int render_queue_capacity = 0;
+
+static RenderStats frame_stats;      // accumulating for the frame in progress
+static RenderStats last_frame_stats; // last completed frame
+
+#define DEG_TO_RAD (3.14159f / 180.0f)
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+// Scratch buffers for building one textured batch, grown on demand
+static float *batch_cos = NULL;
+static float *batch_sin = NULL;
+static SDL_Vertex *batch_vertices = NULL;
+static int *batch_indices = NULL;
+static int batch_capacity = 0; // in quads
+#endif
+
+static void draw_textured(SDL_Texture *texture, const SDL_Rect *src, const RenderCommand *cmd);
+static void draw_textured_batch(SDL_Texture *texture, const QueuedCommand *queued, int count);
+static int reserve_sprite();
+static void load_sprite(int sprite_id, const char *filepath, int builtin);
 
 void engine_init(SDL_Renderer *renderer)
 {
@@ -17,21 +54,49 @@ void engine_init(SDL_Renderer *renderer)
         printf("SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError());
     }
 
-    // Initialise texture array
+    // Initialise sprite table
     for (int i = 0; i < MAX_TEXTURES; i++)
     {
-        textures[i] = NULL;
+        sprites[i].page = -1;
     }
     texture_count = 0;
+    atlas_init(renderer);
 
-    engine_load_texture("engine/assets/player.png"); // ID 0 (Player)
-    engine_load_texture("engine/assets/floor.png");  // ID 1 (TILE_FLOOR)
-    engine_load_texture("engine/assets/wall.png");   // ID 2 (TILE_WALL)
-    engine_load_texture("engine/assets/exit.png");   // ID 3 (TILE_DOOR)
-    engine_load_texture("engine/assets/water.png");  // ID 4 (TILE_WATER)
+    render_queue_capacity = RENDER_QUEUE_INITIAL_CAPACITY;
+    render_queue = malloc(sizeof(QueuedCommand) * render_queue_capacity);
+    render_queue_count = 0;
+    if (!render_queue)
+    {
+        printf("Unable to allocate render queue!\n");
+        render_queue_capacity = 0;
+    }
+
+    job_system_init(0);
+    async_loader_init();
+
+    // Pre-decoded pixels from the asset pack skip PNG decoding entirely; it's optional
+    asset_pack_open(ASSET_PACK_PATH);
+
+    // Builtin sprites always occupy their ID: a missing image is replaced by its procedural shape
+    load_sprite(reserve_sprite(), "engine/assets/player.png", 1); // ID 0 (Player)
+    load_sprite(reserve_sprite(), "engine/assets/floor.png", 1);  // ID 1 (TILE_FLOOR)
+    load_sprite(reserve_sprite(), "engine/assets/wall.png", 1);   // ID 2 (TILE_WALL)
+    load_sprite(reserve_sprite(), "engine/assets/exit.png", 1);   // ID 3 (TILE_DOOR)
+    load_sprite(reserve_sprite(), "engine/assets/water.png", 1);  // ID 4 (TILE_WATER)
+
+    SDL_Surface *missing = engine_create_fallback_surface(-1);
+    if (missing)
+    {
+        atlas_add_surface(missing, &missing_sprite);
+        SDL_FreeSurface(missing);
+    }
+
+    // Builtins decode in parallel, so this waits for the slowest image rather than the sum
+    engine_wait_for_async_loads();
 }
 
-int engine_load_texture(const char *filepath)
+// Claim the next sprite_id; it draws as the missing sprite until an image is packed into it
+static int reserve_sprite()
 {
     if (texture_count >= MAX_TEXTURES)
     {
@@ -39,178 +104,497 @@ int engine_load_texture(const char *filepath)
         return -1;
     }
 
+    sprites[texture_count].page = -1;
+    return texture_count++;
+}
+
+static int pack_sprite(int sprite_id, SDL_Surface *surface, const char *name)
+{
+    // The sub-rect is cached so drawing never queries the texture
+    if (atlas_add_surface(surface, &sprites[sprite_id]) != 0)
+    {
+        printf("Unable to add %s to texture atlas!\n", name);
+        return -1;
+    }
+
+    printf("Loaded texture %s as ID %d (atlas page %d)\n", name, sprite_id, sprites[sprite_id].page);
+    return 0;
+}
+
+// Upload a decoded image into its reserved ID; builtins that failed to decode get their procedural shape
+static void finish_load(int sprite_id, SDL_Surface *surface, const char *filepath, int builtin)
+{
+    const char *name = filepath;
+    if (!surface && builtin)
+    {
+        printf("Using procedural sprite for %s\n", filepath);
+        surface = engine_create_fallback_surface(sprite_id);
+        name = "procedural sprite";
+    }
+
+    if (surface)
+    {
+        pack_sprite(sprite_id, surface, name);
+        SDL_FreeSurface(surface);
+    }
+}
+
+static void load_sprite(int sprite_id, const char *filepath, int builtin)
+{
+    if (sprite_id < 0)
+        return;
+
+    // Packed images are already decoded, upload them straight from the mapping
+    SDL_Surface *packed = asset_pack_surface(filepath);
+    if (packed)
+    {
+        finish_load(sprite_id, packed, filepath, builtin);
+        return;
+    }
+
+    if (async_loader_enqueue(sprite_id, filepath, builtin) == 0)
+        return;
+
+    // No decode thread available, load on this thread instead
     SDL_Surface *surface = IMG_Load(filepath);
     if (!surface)
+    {
+        printf("Unable to load image %s! SDL_image Error: %s\n", filepath, IMG_GetError());
+    }
+    finish_load(sprite_id, surface, filepath, builtin);
+}
+
+int engine_load_texture(const char *filepath)
+{
+    if (texture_count >= MAX_TEXTURES)
+    {
+        printf("Cannot load more textures, max reached!\n");
+        return -1;
+    }
+
+    SDL_Surface *surface = asset_pack_surface(filepath);
+    if (!surface)
+        surface = IMG_Load(filepath);
+    if (!surface)
     {
         printf("Unable to load image %s! SDL_image Error: %s\n", filepath, IMG_GetError());
         return -1;
     }
 
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(sdl_renderer, surface);
+    int sprite_id = reserve_sprite();
+    int packed = pack_sprite(sprite_id, surface, filepath);
     SDL_FreeSurface(surface);
+    return packed == 0 ? sprite_id : -1;
+}
 
-    if (!texture)
+int engine_load_texture_async(const char *filepath)
+{
+    int sprite_id = reserve_sprite();
+    load_sprite(sprite_id, filepath, 0);
+    return sprite_id;
+}
+
+int engine_texture_ready(int sprite_id)
+{
+    return sprite_id >= 0 && sprite_id < texture_count && sprites[sprite_id].page >= 0;
+}
+
+void engine_process_async_loads(float budget_ms)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    float ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0f;
+
+    AsyncLoadResult result;
+    while (async_loader_poll(&result))
     {
-        printf("Unable to create texture from %s! SDL Error: %s\n", filepath, SDL_GetError());
-        return -1;
+        finish_load(result.sprite_id, result.surface, result.filepath, result.builtin);
+
+        if ((SDL_GetPerformanceCounter() - start) / ticks_per_ms >= budget_ms)
+            break;
     }
+}
 
-    textures[texture_count] = texture;
-    printf("Loaded texture %s as ID %d\n", filepath, texture_count);
-    return texture_count++;
+void engine_wait_for_async_loads()
+{
+    AsyncLoadResult result;
+    while (async_loader_wait(&result))
+    {
+        finish_load(result.sprite_id, result.surface, result.filepath, result.builtin);
+    }
 }
 
 void engine_unload_all_textures()
 {
+    // Loads in flight target IDs that are about to be reused
+    engine_wait_for_async_loads();
+
     for (int i = 0; i < texture_count; i++)
     {
-        if (textures[i])
-        {
-            SDL_DestroyTexture(textures[i]);
-            textures[i] = NULL;
-        }
+        sprites[i].page = -1;
     }
+    missing_sprite.page = -1;
+    atlas_clear();
     texture_count = 0;
 }
 
 void engine_begin_frame()
 {
+    frame_stats.world_submitted = 0;
+    frame_stats.world_culled = 0;
+    frame_stats.drawn = 0;
+
+    engine_process_async_loads(ASYNC_UPLOAD_BUDGET_MS);
+
     SDL_SetRenderDrawColor(sdl_renderer, 0, 0, 0, 255);
     SDL_RenderClear(sdl_renderer);
 }
 
+static const AtlasSprite *resolve_sprite(int sprite_id)
+{
+    if (sprite_id >= 0 && sprite_id < texture_count && sprites[sprite_id].page >= 0)
+        return &sprites[sprite_id];
+    return &missing_sprite;
+}
+
 void engine_submit(RenderCommand cmd)
 {
-    // Check if we have a texture for this sprite_id
-    if (cmd.sprite_id >= 0 && cmd.sprite_id < texture_count && textures[cmd.sprite_id])
+    const AtlasSprite *sprite = resolve_sprite(cmd.sprite_id);
+    engine_submit_texture(atlas_page_texture(sprite->page), &sprite->src, cmd);
+}
+
+void engine_submit_texture(SDL_Texture *texture, const SDL_Rect *src, RenderCommand cmd)
+{
+    if (!texture)
+        return;
+
+    // Grow the queue if needed
+    if (render_queue_count >= render_queue_capacity)
     {
-        // Render using texture
-        SDL_Texture *texture = textures[cmd.sprite_id];
+        int new_capacity = render_queue_capacity > 0 ? render_queue_capacity * 2 : RENDER_QUEUE_INITIAL_CAPACITY;
+        QueuedCommand *grown = realloc(render_queue, sizeof(QueuedCommand) * new_capacity);
+        if (!grown)
+        {
+            printf("Render queue full, dropping command!\n");
+            return;
+        }
+        render_queue = grown;
+        render_queue_capacity = new_capacity;
+    }
+
+    QueuedCommand *queued = &render_queue[render_queue_count];
+    queued->cmd = cmd;
+    queued->texture = texture;
+    queued->src = *src;
+    queued->order = render_queue_count;
+    render_queue_count++;
+}
+
+void engine_draw_immediate(const RenderCommand *cmd)
+{
+    const AtlasSprite *sprite = resolve_sprite(cmd->sprite_id);
+    SDL_Texture *texture = atlas_page_texture(sprite->page);
+    if (texture)
+        draw_textured(texture, &sprite->src, cmd);
+}
 
-        // Get texture dimensions
-        int tex_width, tex_height;
-        SDL_QueryTexture(texture, NULL, NULL, &tex_width, &tex_height);
+void engine_get_sprite_size(int sprite_id, int *width, int *height)
+{
+    const AtlasSprite *sprite = resolve_sprite(sprite_id);
+    *width = sprite->src.w;
+    *height = sprite->src.h;
+}
 
-        // Calculate scaled size
-        int scaled_width = (int)(tex_width * cmd.scale);
-        int scaled_height = (int)(tex_height * cmd.scale);
+// Cull against the camera view and convert to screen space in one pass over the batch.
+// Returns the number of commands queued.
+int engine_submit_world(Camera *camera, const RenderCommand *cmds, int count)
+{
+    float half_width = camera->screen_width / 2.0f;
+    float half_height = camera->screen_height / 2.0f;
+    float offset_x = half_width - camera->x;
+    float offset_y = half_height - camera->y;
 
-        // Destination rectangle (where to draw on screen)
-        SDL_Rect dst_rect = {
-            (int)(cmd.x - scaled_width / 2),
-            (int)(cmd.y - scaled_height / 2),
-            scaled_width,
-            scaled_height};
+    int queued = 0;
+    for (int i = 0; i < count; i++)
+    {
+        RenderCommand cmd = cmds[i];
+        const AtlasSprite *sprite = resolve_sprite(cmd.sprite_id);
 
-        // Render with rotation if needed
+        // Half extents of the drawn quad; rotated quads use the half diagonal
+        float extent_x = sprite->src.w * cmd.scale * 0.5f;
+        float extent_y = sprite->src.h * cmd.scale * 0.5f;
         if (cmd.rotation != 0.0f)
         {
-            SDL_RenderCopyEx(sdl_renderer, texture, NULL, &dst_rect, cmd.rotation, NULL, SDL_FLIP_NONE);
+            float radius = sqrtf(extent_x * extent_x + extent_y * extent_y);
+            extent_x = radius;
+            extent_y = radius;
         }
-        else
+
+        float screen_x = cmd.x + offset_x;
+        float screen_y = cmd.y + offset_y;
+        if (screen_x + extent_x < 0.0f || screen_x - extent_x > camera->screen_width ||
+            screen_y + extent_y < 0.0f || screen_y - extent_y > camera->screen_height)
         {
-            SDL_RenderCopy(sdl_renderer, texture, NULL, &dst_rect);
+            continue;
         }
+
+        cmd.x = screen_x;
+        cmd.y = screen_y;
+        engine_submit_texture(atlas_page_texture(sprite->page), &sprite->src, cmd);
+        queued++;
     }
-    else
-    {
-        // Fallback to colored rectangles if texture not found
-        int half_size = (int)(16 * cmd.scale);
-        float angleRad = cmd.rotation * (3.14159f / 180.0f);
 
-        // Different rendering based on sprite_id
-        switch (cmd.sprite_id)
-        {
-        case 0: // Player
-        {
-            float corners[4][2] = {
-                {-half_size, -half_size}, {half_size, -half_size}, {half_size, half_size}, {-half_size, half_size}};
-
-            SDL_Point square_points[5];
-            for (int i = 0; i < 4; i++)
-            {
-                float rotated_x = corners[i][0] * cosf(angleRad) - corners[i][1] * sinf(angleRad);
-                float rotated_y = corners[i][0] * sinf(angleRad) + corners[i][1] * cosf(angleRad);
-
-                square_points[i].x = (int)(cmd.x + rotated_x);
-                square_points[i].y = (int)(cmd.y + rotated_y);
-            }
-            square_points[4] = square_points[0];
-
-            SDL_SetRenderDrawColor(sdl_renderer, 100, 100, 100, 255);
-            SDL_RenderDrawLines(sdl_renderer, square_points, 5);
-
-            // Triangle
-            float tri_size = half_size * 0.8f;
-            SDL_Point p1 = {(int)(cmd.x + cosf(angleRad) * tri_size), (int)(cmd.y + sinf(angleRad) * tri_size)};
-            SDL_Point p2 = {(int)(cmd.x + cosf(angleRad + 2.618f) * (tri_size * 0.6f)), (int)(cmd.y + sinf(angleRad + 2.618f) * (tri_size * 0.6f))};
-            SDL_Point p3 = {(int)(cmd.x + cosf(angleRad - 2.618f) * (tri_size * 0.6f)), (int)(cmd.y + sinf(angleRad - 2.618f) * (tri_size * 0.6f))};
-
-            SDL_SetRenderDrawColor(sdl_renderer, 255, 0, 0, 255);
-            SDL_RenderDrawLine(sdl_renderer, p1.x, p1.y, p2.x, p2.y);
-            SDL_RenderDrawLine(sdl_renderer, p2.x, p2.y, p3.x, p3.y);
-            SDL_RenderDrawLine(sdl_renderer, p3.x, p3.y, p1.x, p1.y);
-            break;
-        }
+    frame_stats.world_submitted += count;
+    frame_stats.world_culled += count - queued;
+    return queued;
+}
+
+void engine_get_render_stats(RenderStats *stats)
+{
+    *stats = last_frame_stats;
+}
+
+SDL_Renderer *engine_get_renderer()
+{
+    return sdl_renderer;
+}
+
+static int compare_queued_commands(const void *a, const void *b)
+{
+    const QueuedCommand *qa = (const QueuedCommand *)a;
+    const QueuedCommand *qb = (const QueuedCommand *)b;
+
+    if (qa->cmd.layer != qb->cmd.layer)
+        return qa->cmd.layer < qb->cmd.layer ? -1 : 1;
+    if (qa->texture != qb->texture)
+        return (uintptr_t)qa->texture < (uintptr_t)qb->texture ? -1 : 1;
+    if (qa->cmd.sprite_id != qb->cmd.sprite_id)
+        return qa->cmd.sprite_id < qb->cmd.sprite_id ? -1 : 1;
+    return qa->order - qb->order;
+}
 
-        case TILE_FLOOR: // Floor tiles (1)
+static void flush_render_queue()
+{
+    frame_stats.drawn = render_queue_count;
+    qsort(render_queue, render_queue_count, sizeof(QueuedCommand), compare_queued_commands);
+
+    int i = 0;
+    while (i < render_queue_count)
+    {
+        // Find the run of commands sharing this layer and texture
+        int layer = render_queue[i].cmd.layer;
+        SDL_Texture *texture = render_queue[i].texture;
+        int run_end = i + 1;
+        while (run_end < render_queue_count &&
+               render_queue[run_end].cmd.layer == layer &&
+               render_queue[run_end].texture == texture)
         {
-            SDL_Rect floor_rect = {(int)(cmd.x - half_size), (int)(cmd.y - half_size), half_size * 2, half_size * 2};
-            SDL_SetRenderDrawColor(sdl_renderer, 139, 69, 19, 255); // Brown
-            SDL_RenderFillRect(sdl_renderer, &floor_rect);
-            break;
+            run_end++;
         }
 
-        case TILE_WALL: // Wall tiles (2)
+        draw_textured_batch(texture, &render_queue[i], run_end - i);
+
+        i = run_end;
+    }
+
+    render_queue_count = 0;
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+static int ensure_batch_capacity(int quads)
+{
+    if (quads <= batch_capacity)
+        return 1;
+
+    int new_capacity = batch_capacity > 0 ? batch_capacity : 1024;
+    while (new_capacity < quads)
+        new_capacity *= 2;
+
+    float *grown_cos = realloc(batch_cos, sizeof(float) * new_capacity);
+    if (grown_cos)
+        batch_cos = grown_cos;
+    float *grown_sin = realloc(batch_sin, sizeof(float) * new_capacity);
+    if (grown_sin)
+        batch_sin = grown_sin;
+    SDL_Vertex *grown_vertices = realloc(batch_vertices, sizeof(SDL_Vertex) * 4 * new_capacity);
+    if (grown_vertices)
+        batch_vertices = grown_vertices;
+    int *grown_indices = realloc(batch_indices, sizeof(int) * 6 * new_capacity);
+    if (grown_indices)
+        batch_indices = grown_indices;
+
+    if (!grown_cos || !grown_sin || !grown_vertices || !grown_indices)
+    {
+        printf("Unable to grow sprite batch buffers!\n");
+        return 0;
+    }
+
+    // The index pattern never changes, so only the new quads need filling in
+    for (int q = batch_capacity; q < new_capacity; q++)
+    {
+        int *idx = &batch_indices[q * 6];
+        int base = q * 4;
+        idx[0] = base + 0;
+        idx[1] = base + 1;
+        idx[2] = base + 2;
+        idx[3] = base + 0;
+        idx[4] = base + 2;
+        idx[5] = base + 3;
+    }
+
+    batch_capacity = new_capacity;
+    return 1;
+}
+#endif
+
+// One SDL_RenderCopyEx per command, for when geometry batching isn't available
+static void draw_textured_each(SDL_Texture *texture, const QueuedCommand *queued, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        draw_textured(texture, &queued[i].src, &queued[i].cmd);
+    }
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+// Transform a run of commands sharing a texture into one vertex array and draw it with a single call
+static void draw_textured_batch(SDL_Texture *texture, const QueuedCommand *queued, int count)
+{
+    if (!ensure_batch_capacity(count))
+    {
+        draw_textured_each(texture, queued, count);
+        return;
+    }
+
+    int tex_width, tex_height;
+    SDL_QueryTexture(texture, NULL, NULL, &tex_width, &tex_height);
+    float inv_width = 1.0f / tex_width;
+    float inv_height = 1.0f / tex_height;
+
+    // Rotation terms for the whole batch in one pass
+    for (int i = 0; i < count; i++)
+    {
+        float rotation = queued[i].cmd.rotation;
+        if (rotation != 0.0f)
         {
-            SDL_Rect wall_rect = {(int)(cmd.x - half_size), (int)(cmd.y - half_size), half_size * 2, half_size * 2};
-            SDL_SetRenderDrawColor(sdl_renderer, 64, 64, 64, 255); // Dark gray
-            SDL_RenderFillRect(sdl_renderer, &wall_rect);
-            SDL_SetRenderDrawColor(sdl_renderer, 32, 32, 32, 255); // Darker border
-            SDL_RenderDrawRect(sdl_renderer, &wall_rect);
-            break;
+            batch_cos[i] = cosf(rotation * DEG_TO_RAD);
+            batch_sin[i] = sinf(rotation * DEG_TO_RAD);
         }
-
-        case TILE_DOOR: // Door tiles (3)
+        else
         {
-            SDL_Rect door_rect = {(int)(cmd.x - half_size), (int)(cmd.y - half_size), half_size * 2, half_size * 2};
-            SDL_SetRenderDrawColor(sdl_renderer, 101, 67, 33, 255); // Dark brown
-            SDL_RenderFillRect(sdl_renderer, &door_rect);
-
-            SDL_Rect handle = {(int)(cmd.x + half_size / 2), (int)(cmd.y), 3, 6};
-            SDL_SetRenderDrawColor(sdl_renderer, 255, 215, 0, 255); // Gold
-            SDL_RenderFillRect(sdl_renderer, &handle);
-            break;
+            batch_cos[i] = 1.0f;
+            batch_sin[i] = 0.0f;
         }
+    }
 
-        case TILE_WATER: // Water tiles (4)
-        {
-            SDL_Rect water_rect = {(int)(cmd.x - half_size), (int)(cmd.y - half_size), half_size * 2, half_size * 2};
-            SDL_SetRenderDrawColor(sdl_renderer, 0, 100, 200, 255); // Blue
-            SDL_RenderFillRect(sdl_renderer, &water_rect);
+    // Corner positions: center +/- the rotated half-extent axes
+    SDL_Color white = {255, 255, 255, 255};
+    for (int i = 0; i < count; i++)
+    {
+        const RenderCommand *cmd = &queued[i].cmd;
+        const SDL_Rect *src = &queued[i].src;
+
+        float half_w = src->w * cmd->scale * 0.5f;
+        float half_h = src->h * cmd->scale * 0.5f;
+        float ax = half_w * batch_cos[i];
+        float ay = half_w * batch_sin[i];
+        float bx = -half_h * batch_sin[i];
+        float by = half_h * batch_cos[i];
+
+        float u0 = src->x * inv_width;
+        float v0 = src->y * inv_height;
+        float u1 = (src->x + src->w) * inv_width;
+        float v1 = (src->y + src->h) * inv_height;
+
+        SDL_Vertex *v = &batch_vertices[i * 4];
+        v[0].position.x = cmd->x - ax - bx;
+        v[0].position.y = cmd->y - ay - by;
+        v[0].tex_coord.x = u0;
+        v[0].tex_coord.y = v0;
+
+        v[1].position.x = cmd->x + ax - bx;
+        v[1].position.y = cmd->y + ay - by;
+        v[1].tex_coord.x = u1;
+        v[1].tex_coord.y = v0;
+
+        v[2].position.x = cmd->x + ax + bx;
+        v[2].position.y = cmd->y + ay + by;
+        v[2].tex_coord.x = u1;
+        v[2].tex_coord.y = v1;
+
+        v[3].position.x = cmd->x - ax + bx;
+        v[3].position.y = cmd->y - ay + by;
+        v[3].tex_coord.x = u0;
+        v[3].tex_coord.y = v1;
+
+        v[0].color = white;
+        v[1].color = white;
+        v[2].color = white;
+        v[3].color = white;
+    }
 
-            SDL_SetRenderDrawColor(sdl_renderer, 0, 150, 255, 255); // Light blue
-            SDL_RenderDrawLine(sdl_renderer, (int)(cmd.x - half_size), (int)(cmd.y - half_size / 2), (int)(cmd.x + half_size), (int)(cmd.y - half_size / 2));
-            SDL_RenderDrawLine(sdl_renderer, (int)(cmd.x - half_size), (int)(cmd.y + half_size / 2), (int)(cmd.x + half_size), (int)(cmd.y + half_size / 2));
-            break;
-        }
+    SDL_RenderGeometry(sdl_renderer, texture, batch_vertices, count * 4, batch_indices, count * 6);
+}
+#else
+// SDL_RenderGeometry needs SDL 2.0.18
+static void draw_textured_batch(SDL_Texture *texture, const QueuedCommand *queued, int count)
+{
+    draw_textured_each(texture, queued, count);
+}
+#endif
 
-        default:
-            SDL_Rect debug_rect = {(int)(cmd.x - half_size), (int)(cmd.y - half_size), half_size * 2, half_size * 2};
-            SDL_SetRenderDrawColor(sdl_renderer, 255, 0, 255, 255); // Magenta
-            SDL_RenderFillRect(sdl_renderer, &debug_rect);
-            break;
-        }
+static void draw_textured(SDL_Texture *texture, const SDL_Rect *src, const RenderCommand *cmd)
+{
+    // Calculate scaled size
+    int scaled_width = (int)(src->w * cmd->scale);
+    int scaled_height = (int)(src->h * cmd->scale);
+
+    // Destination rectangle (where to draw on screen)
+    SDL_Rect dst_rect = {
+        (int)(cmd->x - scaled_width / 2),
+        (int)(cmd->y - scaled_height / 2),
+        scaled_width,
+        scaled_height};
+
+    // Render with rotation if needed
+    if (cmd->rotation != 0.0f)
+    {
+        SDL_RenderCopyEx(sdl_renderer, texture, src, &dst_rect, cmd->rotation, NULL, SDL_FLIP_NONE);
+    }
+    else
+    {
+        SDL_RenderCopy(sdl_renderer, texture, src, &dst_rect);
     }
 }
 
 void engine_end_frame()
 {
+    flush_render_queue();
     SDL_RenderPresent(sdl_renderer);
+    last_frame_stats = frame_stats;
 }
 
 void engine_shutdown()
 {
+    async_loader_shutdown();
+    engine_unload_all_textures();
+    asset_pack_close();
+    job_system_shutdown();
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    free(batch_cos);
+    free(batch_sin);
+    free(batch_vertices);
+    free(batch_indices);
+    batch_cos = NULL;
+    batch_sin = NULL;
+    batch_vertices = NULL;
+    batch_indices = NULL;
+    batch_capacity = 0;
+#endif
+
+    free(render_queue);
+    render_queue = NULL;
+    render_queue_count = 0;
+    render_queue_capacity = 0;
     sdl_renderer = NULL;
 }
 
@@ -0,0 +1,19 @@
+#ifndef ENGINE_INTERNAL_H
+#define ENGINE_INTERNAL_H
+
+#include "engine.h"
+
+// Shared between engine translation units, not part of the public API
+
+SDL_Renderer *engine_get_renderer();
+
+// Queue a command that draws src from an arbitrary texture instead of a sprite
+void engine_submit_texture(SDL_Texture *texture, const SDL_Rect *src, RenderCommand cmd);
+
+// Draw a sprite right away, bypassing the queue (used when baking render targets)
+void engine_draw_immediate(const RenderCommand *cmd);
+
+// Rasterize the procedural stand-in for a builtin sprite (magenta square for unknown ids)
+SDL_Surface *engine_create_fallback_surface(int sprite_id);
+
+#endif
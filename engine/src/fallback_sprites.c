@@ -0,0 +1,123 @@
+#include "engine_internal.h"
+#include <math.h>
+
+// Procedural stand-ins for missing sprite images, rasterized once on the CPU
+// so they can be packed into the atlas like any other image.
+
+#define FALLBACK_SPRITE_SIZE 32
+
+static void put_pixel(SDL_Surface *surface, int x, int y, Uint32 color)
+{
+    if (x < 0 || x >= surface->w || y < 0 || y >= surface->h)
+        return;
+    Uint32 *row = (Uint32 *)((Uint8 *)surface->pixels + y * surface->pitch);
+    row[x] = color;
+}
+
+static void draw_line(SDL_Surface *surface, int x0, int y0, int x1, int y1, Uint32 color)
+{
+    // Bresenham
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+
+    while (1)
+    {
+        put_pixel(surface, x0, y0, color);
+        if (x0 == x1 && y0 == y1)
+            break;
+        int e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+static void draw_rect_outline(SDL_Surface *surface, int x, int y, int w, int h, Uint32 color)
+{
+    draw_line(surface, x, y, x + w - 1, y, color);
+    draw_line(surface, x + w - 1, y, x + w - 1, y + h - 1, color);
+    draw_line(surface, x + w - 1, y + h - 1, x, y + h - 1, color);
+    draw_line(surface, x, y + h - 1, x, y, color);
+}
+
+SDL_Surface *engine_create_fallback_surface(int sprite_id)
+{
+    const int size = FALLBACK_SPRITE_SIZE;
+    const int half_size = size / 2;
+
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!surface)
+    {
+        printf("Unable to create fallback sprite surface! SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    SDL_PixelFormat *fmt = surface->format;
+    // Freshly created RGBA surfaces don't need locking for direct pixel access
+    SDL_FillRect(surface, NULL, SDL_MapRGBA(fmt, 0, 0, 0, 0));
+
+    switch (sprite_id)
+    {
+    case 0: // Player
+    {
+        // Square outline with a triangle pointing along +x (rotation 0)
+        draw_rect_outline(surface, 0, 0, size, size, SDL_MapRGBA(fmt, 100, 100, 100, 255));
+
+        float tri_size = half_size * 0.8f;
+        int p1x = (int)(half_size + tri_size);
+        int p1y = half_size;
+        int p2x = (int)(half_size + cosf(2.618f) * (tri_size * 0.6f));
+        int p2y = (int)(half_size + sinf(2.618f) * (tri_size * 0.6f));
+        int p3x = (int)(half_size + cosf(-2.618f) * (tri_size * 0.6f));
+        int p3y = (int)(half_size + sinf(-2.618f) * (tri_size * 0.6f));
+
+        Uint32 red = SDL_MapRGBA(fmt, 255, 0, 0, 255);
+        draw_line(surface, p1x, p1y, p2x, p2y, red);
+        draw_line(surface, p2x, p2y, p3x, p3y, red);
+        draw_line(surface, p3x, p3y, p1x, p1y, red);
+        break;
+    }
+
+    case TILE_FLOOR: // Floor tiles (1)
+        SDL_FillRect(surface, NULL, SDL_MapRGBA(fmt, 139, 69, 19, 255)); // Brown
+        break;
+
+    case TILE_WALL: // Wall tiles (2)
+        SDL_FillRect(surface, NULL, SDL_MapRGBA(fmt, 64, 64, 64, 255)); // Dark gray
+        draw_rect_outline(surface, 0, 0, size, size, SDL_MapRGBA(fmt, 32, 32, 32, 255)); // Darker border
+        break;
+
+    case TILE_DOOR: // Door tiles (3)
+    {
+        SDL_FillRect(surface, NULL, SDL_MapRGBA(fmt, 101, 67, 33, 255)); // Dark brown
+        SDL_Rect handle = {half_size + half_size / 2, half_size, 3, 6};
+        SDL_FillRect(surface, &handle, SDL_MapRGBA(fmt, 255, 215, 0, 255)); // Gold
+        break;
+    }
+
+    case TILE_WATER: // Water tiles (4)
+    {
+        SDL_FillRect(surface, NULL, SDL_MapRGBA(fmt, 0, 100, 200, 255)); // Blue
+        Uint32 light_blue = SDL_MapRGBA(fmt, 0, 150, 255, 255);
+        draw_line(surface, 0, half_size / 2, size - 1, half_size / 2, light_blue);
+        draw_line(surface, 0, half_size + half_size / 2, size - 1, half_size + half_size / 2, light_blue);
+        break;
+    }
+
+    default:
+        SDL_FillRect(surface, NULL, SDL_MapRGBA(fmt, 255, 0, 255, 255)); // Magenta
+        break;
+    }
+
+    return surface;
+}
@@ -0,0 +1,107 @@
+#include "frame_pacer.h"
+#include <math.h>
+#include <stdio.h>
+
+void frame_pacer_init(FramePacer *pacer, SDL_Renderer *renderer, FramePaceMode mode, double target_fps)
+{
+    if (mode == FRAME_PACE_TARGET_FPS && target_fps <= 0.0)
+    {
+        printf("Invalid target FPS %.1f, running uncapped\n", target_fps);
+        mode = FRAME_PACE_UNCAPPED;
+    }
+
+    pacer->mode = mode;
+    pacer->target_fps = target_fps;
+    pacer->frequency = SDL_GetPerformanceFrequency();
+    pacer->frame_ticks = mode == FRAME_PACE_TARGET_FPS ? (Uint64)(pacer->frequency / target_fps) : 0;
+    pacer->last_frame_end = SDL_GetPerformanceCounter();
+    pacer->next_deadline = pacer->last_frame_end + pacer->frame_ticks;
+    pacer->history_count = 0;
+    pacer->history_index = 0;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    // Only the vsync mode should block in SDL_RenderPresent
+    if (SDL_RenderSetVSync(renderer, mode == FRAME_PACE_VSYNC ? 1 : 0) != 0)
+    {
+        printf("Unable to change vsync! SDL Error: %s\n", SDL_GetError());
+    }
+#else
+    (void)renderer;
+#endif
+}
+
+static void wait_until(FramePacer *pacer, Uint64 deadline)
+{
+    Uint64 spin_ticks = (Uint64)(pacer->frequency * (FRAME_PACER_SPIN_MS / 1000.0));
+
+    // Sleep in 1ms slices while the deadline is comfortably far away: the scheduler
+    // may oversleep each slice, so the last stretch is left to the spin below
+    Uint64 now = SDL_GetPerformanceCounter();
+    while (now + spin_ticks < deadline)
+    {
+        SDL_Delay(1);
+        now = SDL_GetPerformanceCounter();
+    }
+
+    while (now < deadline)
+    {
+        now = SDL_GetPerformanceCounter();
+    }
+}
+
+// Call once per frame, after engine_end_frame()
+void frame_pacer_wait(FramePacer *pacer)
+{
+    if (pacer->mode == FRAME_PACE_TARGET_FPS)
+    {
+        wait_until(pacer, pacer->next_deadline);
+
+        // Fixed cadence; if we fell more than a frame behind, restart from now rather than bursting
+        Uint64 now = SDL_GetPerformanceCounter();
+        pacer->next_deadline += pacer->frame_ticks;
+        if (pacer->next_deadline < now)
+            pacer->next_deadline = now + pacer->frame_ticks;
+    }
+
+    Uint64 frame_end = SDL_GetPerformanceCounter();
+    float frame_ms = (float)((frame_end - pacer->last_frame_end) * 1000.0 / pacer->frequency);
+    pacer->last_frame_end = frame_end;
+
+    pacer->history_ms[pacer->history_index] = frame_ms;
+    pacer->history_index = (pacer->history_index + 1) % FRAME_STATS_WINDOW;
+    if (pacer->history_count < FRAME_STATS_WINDOW)
+        pacer->history_count++;
+}
+
+void frame_pacer_get_stats(const FramePacer *pacer, FrameStats *stats)
+{
+    stats->samples = pacer->history_count;
+    stats->mean_ms = 0.0;
+    stats->stddev_ms = 0.0;
+    stats->min_ms = 0.0;
+    stats->max_ms = 0.0;
+    if (pacer->history_count == 0)
+        return;
+
+    double sum = 0.0;
+    stats->min_ms = pacer->history_ms[0];
+    stats->max_ms = pacer->history_ms[0];
+    for (int i = 0; i < pacer->history_count; i++)
+    {
+        double ms = pacer->history_ms[i];
+        sum += ms;
+        if (ms < stats->min_ms)
+            stats->min_ms = ms;
+        if (ms > stats->max_ms)
+            stats->max_ms = ms;
+    }
+    stats->mean_ms = sum / pacer->history_count;
+
+    double variance = 0.0;
+    for (int i = 0; i < pacer->history_count; i++)
+    {
+        double diff = pacer->history_ms[i] - stats->mean_ms;
+        variance += diff * diff;
+    }
+    stats->stddev_ms = sqrt(variance / pacer->history_count);
+}
@@ -0,0 +1,370 @@
+#include "job_system.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define JOB_QUEUE_MASK (JOB_QUEUE_SIZE - 1)
+#define JOB_IDLE_SPINS 64 // failed steal rounds before a worker or waiter sleeps
+
+typedef struct {
+    JobFunc func;
+    void *userdata;
+    int begin, end;
+    JobCounter *counter;
+} Job;
+
+// Front is where thieves take from, back is the owner's end. Short critical sections
+// under a spinlock keep this simple; contention only happens while stealing.
+typedef struct {
+    SDL_SpinLock lock;
+    unsigned front, back;
+    Job jobs[JOB_QUEUE_SIZE];
+} JobDeque;
+
+// The first JOB_SYSTEM_MAX_SUBMITTERS deques belong to threads that aren't workers,
+// handed out as they first submit; worker i owns the deque after those
+static JobDeque *deques = NULL;
+static SDL_Thread *threads[JOB_SYSTEM_MAX_WORKERS];
+static int worker_count = 0;
+static SDL_TLSID worker_slot = 0; // deque index + 1 of the current thread, unset if it has none
+static SDL_atomic_t submitter_used[JOB_SYSTEM_MAX_SUBMITTERS];
+
+static SDL_atomic_t queued_jobs;
+static SDL_atomic_t sleeping_workers;
+static SDL_mutex *sleep_mutex = NULL;
+static SDL_cond *wake_cond = NULL;
+
+// Threads in job_wait sleep here once they run out of jobs; woken when a counter drops to zero
+static SDL_atomic_t waiting_threads;
+static SDL_mutex *done_mutex = NULL;
+static SDL_cond *done_cond = NULL;
+static int stopping = 0;
+static int deterministic = 0;
+
+static int push_back(JobDeque *deque, const Job *job)
+{
+    SDL_AtomicLock(&deque->lock);
+    if (deque->back - deque->front == JOB_QUEUE_SIZE)
+    {
+        SDL_AtomicUnlock(&deque->lock);
+        return 0;
+    }
+    deque->jobs[deque->back & JOB_QUEUE_MASK] = *job;
+    deque->back++;
+    SDL_AtomicUnlock(&deque->lock);
+    return 1;
+}
+
+static int pop_back(JobDeque *deque, Job *job)
+{
+    SDL_AtomicLock(&deque->lock);
+    if (deque->back == deque->front)
+    {
+        SDL_AtomicUnlock(&deque->lock);
+        return 0;
+    }
+    deque->back--;
+    *job = deque->jobs[deque->back & JOB_QUEUE_MASK];
+    SDL_AtomicUnlock(&deque->lock);
+    return 1;
+}
+
+static int steal_front(JobDeque *deque, Job *job)
+{
+    SDL_AtomicLock(&deque->lock);
+    if (deque->back == deque->front)
+    {
+        SDL_AtomicUnlock(&deque->lock);
+        return 0;
+    }
+    *job = deque->jobs[deque->front & JOB_QUEUE_MASK];
+    deque->front++;
+    SDL_AtomicUnlock(&deque->lock);
+    return 1;
+}
+
+// Deque index of the current thread, -1 if it has none
+static int current_slot()
+{
+    return (int)(intptr_t)SDL_TLSGet(worker_slot) - 1;
+}
+
+static void release_submitter_slot(void *value)
+{
+    SDL_AtomicSet(&submitter_used[(intptr_t)value - 1], 0);
+}
+
+// Deque for a thread that isn't a worker, claimed on its first submit and released
+// when the thread exits. -1 if all are taken.
+static int submitter_slot()
+{
+    int self = current_slot();
+    if (self >= 0)
+        return self;
+
+    for (int i = 0; i < JOB_SYSTEM_MAX_SUBMITTERS; i++)
+    {
+        if (SDL_AtomicCAS(&submitter_used[i], 0, 1))
+        {
+            SDL_TLSSet(worker_slot, (void *)(intptr_t)(i + 1), release_submitter_slot);
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Own deque newest-first, then, for workers only, everyone else's oldest-first. Other
+// threads never steal, so one waiting on its own batch can't get stuck running a long
+// job some other thread submitted.
+static int find_job(int self, Job *job)
+{
+    if (SDL_AtomicGet(&queued_jobs) == 0)
+        return 0;
+
+    int found = (self >= 0 && pop_back(&deques[self], job));
+    if (self >= JOB_SYSTEM_MAX_SUBMITTERS)
+    {
+        int deque_count = JOB_SYSTEM_MAX_SUBMITTERS + worker_count;
+        for (int i = 1; !found && i < deque_count; i++)
+        {
+            int victim = (self + i) % deque_count;
+            found = steal_front(&deques[victim], job);
+        }
+    }
+
+    if (found)
+        SDL_AtomicAdd(&queued_jobs, -1);
+    return found;
+}
+
+static void run_job(const Job *job)
+{
+    job->func(job->userdata, job->begin, job->end);
+    if (job->counter && SDL_AtomicAdd(&job->counter->pending, -1) == 1 && SDL_AtomicGet(&waiting_threads) > 0)
+    {
+        SDL_LockMutex(done_mutex);
+        SDL_CondBroadcast(done_cond);
+        SDL_UnlockMutex(done_mutex);
+    }
+}
+
+static int worker_main(void *data)
+{
+    int self = (int)(intptr_t)data - 1;
+    SDL_TLSSet(worker_slot, data, NULL);
+
+    int idle = 0;
+    while (1)
+    {
+        Job job;
+        if (find_job(self, &job))
+        {
+            run_job(&job);
+            idle = 0;
+            continue;
+        }
+        if (++idle < JOB_IDLE_SPINS)
+            continue;
+
+        // Submitters bump queued_jobs before checking for sleepers, so a job queued after
+        // the check below still finds this worker waiting and wakes it
+        SDL_LockMutex(sleep_mutex);
+        SDL_AtomicAdd(&sleeping_workers, 1);
+        while (!stopping && SDL_AtomicGet(&queued_jobs) == 0)
+            SDL_CondWait(wake_cond, sleep_mutex);
+        SDL_AtomicAdd(&sleeping_workers, -1);
+        int stop = stopping;
+        SDL_UnlockMutex(sleep_mutex);
+        if (stop)
+            break;
+        idle = 0;
+    }
+    return 0;
+}
+
+// worker_count <= 0 uses one worker per extra core; threads waiting on jobs also run them
+void job_system_init(int requested)
+{
+    if (sleep_mutex)
+        return;
+
+    if (requested <= 0)
+        requested = SDL_GetCPUCount() - 1;
+    if (requested > JOB_SYSTEM_MAX_WORKERS)
+        requested = JOB_SYSTEM_MAX_WORKERS;
+    if (requested < 0)
+        requested = 0;
+
+    deques = (JobDeque *)calloc(JOB_SYSTEM_MAX_SUBMITTERS + requested, sizeof(JobDeque));
+    if (!deques)
+    {
+        printf("Unable to allocate job queues, running jobs inline\n");
+        return;
+    }
+
+    worker_slot = SDL_TLSCreate();
+    sleep_mutex = SDL_CreateMutex();
+    wake_cond = SDL_CreateCond();
+    done_mutex = SDL_CreateMutex();
+    done_cond = SDL_CreateCond();
+    SDL_AtomicSet(&queued_jobs, 0);
+    SDL_AtomicSet(&sleeping_workers, 0);
+    SDL_AtomicSet(&waiting_threads, 0);
+    stopping = 0;
+
+    worker_count = 0;
+    for (int i = 0; i < requested; i++)
+    {
+        int slot = JOB_SYSTEM_MAX_SUBMITTERS + worker_count;
+        threads[worker_count] = SDL_CreateThread(worker_main, "job_worker", (void *)(intptr_t)(slot + 1));
+        if (!threads[worker_count])
+        {
+            printf("Unable to start job worker! SDL Error: %s\n", SDL_GetError());
+            break;
+        }
+        worker_count++;
+    }
+}
+
+void job_system_shutdown()
+{
+    if (!sleep_mutex)
+        return;
+
+    SDL_LockMutex(sleep_mutex);
+    stopping = 1;
+    SDL_CondBroadcast(wake_cond);
+    SDL_UnlockMutex(sleep_mutex);
+
+    for (int i = 0; i < worker_count; i++)
+    {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    worker_count = 0;
+
+    SDL_DestroyCond(wake_cond);
+    SDL_DestroyMutex(sleep_mutex);
+    SDL_DestroyCond(done_cond);
+    SDL_DestroyMutex(done_mutex);
+    wake_cond = NULL;
+    sleep_mutex = NULL;
+    done_cond = NULL;
+    done_mutex = NULL;
+    free(deques);
+    deques = NULL;
+}
+
+// Number of threads that run jobs, including the caller
+int job_system_thread_count()
+{
+    return worker_count + 1;
+}
+
+// Deterministic mode runs every job inline on the submitting thread, in submission
+// order, so results can't depend on scheduling. Meant for tests and replays.
+void job_system_set_deterministic(int enabled)
+{
+    deterministic = enabled;
+}
+
+int job_system_is_deterministic()
+{
+    return deterministic;
+}
+
+void job_submit(JobFunc func, void *userdata, int begin, int end, JobCounter *counter)
+{
+    Job job = {func, userdata, begin, end, NULL};
+
+    if (deterministic || worker_count == 0)
+    {
+        run_job(&job);
+        return;
+    }
+
+    int slot = submitter_slot();
+    if (slot < 0)
+    {
+        run_job(&job);
+        return;
+    }
+
+    job.counter = counter;
+    if (counter)
+        SDL_AtomicAdd(&counter->pending, 1);
+
+    if (!push_back(&deques[slot], &job))
+    {
+        run_job(&job);
+        return;
+    }
+
+    SDL_AtomicAdd(&queued_jobs, 1);
+    if (SDL_AtomicGet(&sleeping_workers) > 0)
+    {
+        SDL_LockMutex(sleep_mutex);
+        SDL_CondSignal(wake_cond);
+        SDL_UnlockMutex(sleep_mutex);
+    }
+}
+
+// Returns once every job counted by counter has finished, running jobs meanwhile.
+// When there is nothing left to run it spins a little, then sleeps until some counter
+// reaches zero.
+void job_wait(JobCounter *counter)
+{
+    int self = current_slot();
+    int idle = 0;
+    while (SDL_AtomicGet(&counter->pending) > 0)
+    {
+        Job job;
+        if (find_job(self, &job))
+        {
+            run_job(&job);
+            idle = 0;
+            continue;
+        }
+        if (++idle < JOB_IDLE_SPINS)
+            continue;
+
+        // run_job drops the count before checking for waiters, so a batch finishing
+        // after the check below still finds this thread waiting and wakes it
+        SDL_LockMutex(done_mutex);
+        SDL_AtomicAdd(&waiting_threads, 1);
+        if (SDL_AtomicGet(&counter->pending) > 0)
+            SDL_CondWait(done_cond, done_mutex);
+        SDL_AtomicAdd(&waiting_threads, -1);
+        SDL_UnlockMutex(done_mutex);
+        idle = 0;
+    }
+}
+
+// Run func over [0, count) in ranges of grain items (<= 0 picks a few ranges per
+// thread) and wait for all of them
+void job_parallel_for(int count, int grain, JobFunc func, void *userdata)
+{
+    if (count <= 0)
+        return;
+
+    if (grain <= 0)
+    {
+        grain = count / (job_system_thread_count() * 4);
+        if (grain < 1)
+            grain = 1;
+    }
+
+    if (deterministic || worker_count == 0 || count <= grain)
+    {
+        for (int begin = 0; begin < count; begin += grain)
+            func(userdata, begin, begin + grain < count ? begin + grain : count);
+        return;
+    }
+
+    JobCounter counter = {{0}};
+    for (int begin = grain; begin < count; begin += grain)
+        job_submit(func, userdata, begin, begin + grain < count ? begin + grain : count, &counter);
+
+    // First range on this thread while the workers pick up the rest
+    func(userdata, 0, grain);
+    job_wait(&counter);
+}
@@ -0,0 +1,337 @@
+#include "tile_cache.h"
+#include "engine_internal.h"
+#include <string.h>
+#include <math.h>
+
+#define CHUNK_PIXELS (TILE_CHUNK_SIZE * TILE_SIZE)
+
+TileCache *tile_cache_create(Map *map)
+{
+    TileCache *cache = (TileCache *)malloc(sizeof(TileCache));
+    if (!cache)
+        return NULL;
+
+    cache->map = map;
+    cache->chunks_w = (map->width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    cache->chunks_h = (map->height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    cache->frame = 0;
+
+    int chunk_count = cache->chunks_w * cache->chunks_h;
+    cache->dirty = (uint8_t *)calloc(chunk_count, sizeof(uint8_t));
+    cache->slot_of_chunk = (int *)malloc(sizeof(int) * chunk_count);
+    if (!cache->dirty || !cache->slot_of_chunk)
+    {
+        printf("Unable to allocate tile cache chunks!\n");
+        free(cache->dirty);
+        free(cache->slot_of_chunk);
+        free(cache);
+        return NULL;
+    }
+    for (int i = 0; i < chunk_count; i++)
+    {
+        cache->slot_of_chunk[i] = -1;
+    }
+
+    // Sprites larger than a tile overlap their neighbours, so chunks also bake
+    // the tiles just outside their edges
+    int max_half_extent = TILE_SIZE / 2;
+    for (int id = 0; id < 256; id++)
+    {
+        int w, h;
+        engine_get_sprite_size(id, &w, &h);
+        if (w / 2 > max_half_extent)
+            max_half_extent = w / 2;
+        if (h / 2 > max_half_extent)
+            max_half_extent = h / 2;
+    }
+    cache->margin = (max_half_extent - TILE_SIZE / 2 + TILE_SIZE - 1) / TILE_SIZE;
+
+    SDL_Renderer *renderer = engine_get_renderer();
+    cache->use_targets = SDL_RenderTargetSupported(renderer) ? 1 : 0;
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++)
+    {
+        TileChunkSlot *slot = &cache->slots[i];
+        slot->chunk_x = -1;
+        slot->chunk_y = -1;
+        slot->last_used = 0;
+        slot->texture = NULL;
+
+        if (!cache->use_targets)
+            continue;
+
+        slot->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+                                          CHUNK_PIXELS, CHUNK_PIXELS);
+        if (!slot->texture)
+        {
+            printf("Unable to create tile chunk target, drawing tiles directly! SDL Error: %s\n", SDL_GetError());
+            cache->use_targets = 0;
+        }
+    }
+
+    return cache;
+}
+
+void tile_cache_destroy(TileCache *cache)
+{
+    if (!cache)
+        return;
+
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++)
+    {
+        if (cache->slots[i].texture)
+            SDL_DestroyTexture(cache->slots[i].texture);
+    }
+    free(cache->dirty);
+    free(cache->slot_of_chunk);
+    free(cache);
+}
+
+// Point the cache at another map, keeping the slot textures. Every chunk starts out
+// unbaked. Returns -1 if the per-chunk arrays can't be grown; the cache is unchanged then.
+int tile_cache_set_map(TileCache *cache, Map *map)
+{
+    int chunks_w = (map->width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    int chunks_h = (map->height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    int chunk_count = chunks_w * chunks_h;
+
+    uint8_t *dirty = (uint8_t *)calloc(chunk_count, sizeof(uint8_t));
+    int *slot_of_chunk = (int *)malloc(sizeof(int) * chunk_count);
+    if (!dirty || !slot_of_chunk)
+    {
+        printf("Unable to allocate tile cache chunks!\n");
+        free(dirty);
+        free(slot_of_chunk);
+        return -1;
+    }
+    for (int i = 0; i < chunk_count; i++)
+    {
+        slot_of_chunk[i] = -1;
+    }
+
+    free(cache->dirty);
+    free(cache->slot_of_chunk);
+    cache->map = map;
+    cache->chunks_w = chunks_w;
+    cache->chunks_h = chunks_h;
+    cache->dirty = dirty;
+    cache->slot_of_chunk = slot_of_chunk;
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++)
+    {
+        cache->slots[i].chunk_x = -1;
+        cache->slots[i].chunk_y = -1;
+        cache->slots[i].last_used = 0;
+    }
+    return 0;
+}
+
+void tile_cache_mark_dirty(TileCache *cache, int tile_x, int tile_y)
+{
+    // A changed tile can show up in every chunk its sprite overlaps
+    int min_cx = (tile_x - cache->margin) / TILE_CHUNK_SIZE;
+    int max_cx = (tile_x + cache->margin) / TILE_CHUNK_SIZE;
+    int min_cy = (tile_y - cache->margin) / TILE_CHUNK_SIZE;
+    int max_cy = (tile_y + cache->margin) / TILE_CHUNK_SIZE;
+
+    for (int cy = min_cy; cy <= max_cy; cy++)
+    {
+        for (int cx = min_cx; cx <= max_cx; cx++)
+        {
+            if (cx >= 0 && cx < cache->chunks_w && cy >= 0 && cy < cache->chunks_h)
+                cache->dirty[cy * cache->chunks_w + cx] = 1;
+        }
+    }
+}
+
+void tile_cache_invalidate_all(TileCache *cache)
+{
+    memset(cache->dirty, 1, cache->chunks_w * cache->chunks_h);
+}
+
+// Draw every tile overlapping the chunk into the currently bound target.
+// Tiles go out grouped by tile type to match the sort order of the render queue.
+static void draw_chunk_tiles(TileCache *cache, int chunk_x, int chunk_y, float origin_x, float origin_y)
+{
+    Map *map = cache->map;
+    int start_x = chunk_x * TILE_CHUNK_SIZE - cache->margin;
+    int start_y = chunk_y * TILE_CHUNK_SIZE - cache->margin;
+    int end_x = (chunk_x + 1) * TILE_CHUNK_SIZE + cache->margin;
+    int end_y = (chunk_y + 1) * TILE_CHUNK_SIZE + cache->margin;
+
+    if (start_x < 0)
+        start_x = 0;
+    if (start_y < 0)
+        start_y = 0;
+    if (end_x > map->width)
+        end_x = map->width;
+    if (end_y > map->height)
+        end_y = map->height;
+
+    // Which tile types appear in this chunk
+    uint8_t present[256] = {0};
+    for (int y = start_y; y < end_y; y++)
+    {
+        for (int x = start_x; x < end_x; x++)
+        {
+            present[get_cell(map, x, y)->tile_type] = 1;
+        }
+    }
+
+    for (int type = 0; type < 256; type++)
+    {
+        if (!present[type])
+            continue;
+
+        for (int y = start_y; y < end_y; y++)
+        {
+            for (int x = start_x; x < end_x; x++)
+            {
+                if (get_cell(map, x, y)->tile_type != type)
+                    continue;
+
+                RenderCommand tile_cmd = {
+                    x * TILE_SIZE + (TILE_SIZE / 2) - origin_x,
+                    y * TILE_SIZE + (TILE_SIZE / 2) - origin_y,
+                    0.0f, // rotation
+                    1.0f, // scale
+                    type, // sprite_id
+                    0     // layer
+                };
+                engine_draw_immediate(&tile_cmd);
+            }
+        }
+    }
+}
+
+static void bake_chunk(TileCache *cache, TileChunkSlot *slot, int chunk_x, int chunk_y)
+{
+    SDL_Renderer *renderer = engine_get_renderer();
+    SDL_Texture *previous_target = SDL_GetRenderTarget(renderer);
+
+    SDL_SetRenderTarget(renderer, slot->texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    draw_chunk_tiles(cache, chunk_x, chunk_y, chunk_x * CHUNK_PIXELS, chunk_y * CHUNK_PIXELS);
+    SDL_SetRenderTarget(renderer, previous_target);
+}
+
+// Returns a slot holding an up-to-date bake of the chunk, or NULL if every slot is in use this frame
+static TileChunkSlot *acquire_chunk(TileCache *cache, int chunk_x, int chunk_y)
+{
+    int chunk_index = chunk_y * cache->chunks_w + chunk_x;
+    int slot_index = cache->slot_of_chunk[chunk_index];
+
+    if (slot_index < 0)
+    {
+        // Evict the least recently used slot not needed this frame
+        for (int i = 0; i < TILE_CACHE_SLOTS; i++)
+        {
+            if (cache->slots[i].last_used == cache->frame && cache->slots[i].chunk_x >= 0)
+                continue;
+            if (slot_index < 0 || cache->slots[i].last_used < cache->slots[slot_index].last_used)
+                slot_index = i;
+        }
+        if (slot_index < 0)
+            return NULL;
+
+        TileChunkSlot *slot = &cache->slots[slot_index];
+        if (slot->chunk_x >= 0)
+            cache->slot_of_chunk[slot->chunk_y * cache->chunks_w + slot->chunk_x] = -1;
+
+        slot->chunk_x = chunk_x;
+        slot->chunk_y = chunk_y;
+        cache->slot_of_chunk[chunk_index] = slot_index;
+        cache->dirty[chunk_index] = 1;
+    }
+
+    TileChunkSlot *slot = &cache->slots[slot_index];
+    if (cache->dirty[chunk_index])
+    {
+        bake_chunk(cache, slot, chunk_x, chunk_y);
+        cache->dirty[chunk_index] = 0;
+    }
+    slot->last_used = cache->frame;
+    return slot;
+}
+
+// Fallback when no render target is available: submit the chunk's tiles one by one
+static void submit_chunk_tiles(TileCache *cache, Camera *camera, int chunk_x, int chunk_y, int layer)
+{
+    Map *map = cache->map;
+    int end_x = (chunk_x + 1) * TILE_CHUNK_SIZE;
+    int end_y = (chunk_y + 1) * TILE_CHUNK_SIZE;
+    if (end_x > map->width)
+        end_x = map->width;
+    if (end_y > map->height)
+        end_y = map->height;
+
+    for (int y = chunk_y * TILE_CHUNK_SIZE; y < end_y; y++)
+    {
+        for (int x = chunk_x * TILE_CHUNK_SIZE; x < end_x; x++)
+        {
+            float screen_x, screen_y;
+            camera_world_to_screen(camera, x * TILE_SIZE + (TILE_SIZE / 2), y * TILE_SIZE + (TILE_SIZE / 2),
+                                   &screen_x, &screen_y);
+
+            RenderCommand tile_cmd = {
+                screen_x, screen_y,
+                0.0f,
+                1.0f,
+                get_cell(map, x, y)->tile_type,
+                layer};
+            engine_submit(tile_cmd);
+        }
+    }
+}
+
+void tile_cache_submit(TileCache *cache, Camera *camera, int layer)
+{
+    cache->frame++;
+
+    // Visible chunk range, padded by the sprite margin so overhanging tiles still show
+    float margin_pixels = cache->margin * TILE_SIZE;
+    float camera_left = camera->x - (camera->screen_width / 2.0f) - margin_pixels;
+    float camera_top = camera->y - (camera->screen_height / 2.0f) - margin_pixels;
+    float camera_right = camera->x + (camera->screen_width / 2.0f) + margin_pixels;
+    float camera_bottom = camera->y + (camera->screen_height / 2.0f) + margin_pixels;
+
+    int start_cx = (int)floorf(camera_left / CHUNK_PIXELS);
+    int start_cy = (int)floorf(camera_top / CHUNK_PIXELS);
+    int end_cx = (int)floorf(camera_right / CHUNK_PIXELS);
+    int end_cy = (int)floorf(camera_bottom / CHUNK_PIXELS);
+
+    // Clamp to map bounds
+    if (start_cx < 0)
+        start_cx = 0;
+    if (start_cy < 0)
+        start_cy = 0;
+    if (end_cx >= cache->chunks_w)
+        end_cx = cache->chunks_w - 1;
+    if (end_cy >= cache->chunks_h)
+        end_cy = cache->chunks_h - 1;
+
+    SDL_Rect src = {0, 0, CHUNK_PIXELS, CHUNK_PIXELS};
+    for (int cy = start_cy; cy <= end_cy; cy++)
+    {
+        for (int cx = start_cx; cx <= end_cx; cx++)
+        {
+            TileChunkSlot *slot = cache->use_targets ? acquire_chunk(cache, cx, cy) : NULL;
+            if (!slot)
+            {
+                submit_chunk_tiles(cache, camera, cx, cy, layer);
+                continue;
+            }
+
+            float screen_x, screen_y;
+            camera_world_to_screen(camera, (cx + 0.5f) * CHUNK_PIXELS, (cy + 0.5f) * CHUNK_PIXELS,
+                                   &screen_x, &screen_y);
+
+            RenderCommand chunk_cmd = {
+                screen_x, screen_y,
+                0.0f,
+                1.0f,
+                -1, // sprite_id (unused, texture given directly)
+                layer};
+            engine_submit_texture(slot->texture, &src, chunk_cmd);
+        }
+    }
+}
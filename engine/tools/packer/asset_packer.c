@@ -0,0 +1,167 @@
+// Offline asset packer: decodes every PNG in a directory once and writes the raw
+// RGBA32 pixels into a single pack that the engine memory-maps at startup.
+//
+// Usage: asset_packer <asset_dir> <output.pack>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "asset_pack.h"
+
+#define MAX_PACK_IMAGES 256
+#define PACK_ALIGNMENT 16 // pixel data offsets are aligned to this
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp((const char *)a, (const char *)b);
+}
+
+static int has_png_extension(const char *name)
+{
+    size_t length = strlen(name);
+    return length > 4 && strcmp(name + length - 4, ".png") == 0;
+}
+
+static void write_padding(FILE *file, uint64_t count)
+{
+    for (uint64_t i = 0; i < count; i++)
+        fputc(0, file);
+}
+
+static uint64_t align_up(uint64_t value)
+{
+    return (value + PACK_ALIGNMENT - 1) & ~(uint64_t)(PACK_ALIGNMENT - 1);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        printf("Usage: %s <asset_dir> <output.pack>\n", argv[0]);
+        return 1;
+    }
+    const char *asset_dir = argv[1];
+    const char *output_path = argv[2];
+
+    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG))
+    {
+        printf("SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError());
+        return 1;
+    }
+
+    // Collect PNG names, sorted so the pack is reproducible
+    static char names[MAX_PACK_IMAGES][ASSET_PACK_NAME_LENGTH];
+    int name_count = 0;
+
+    DIR *dir = opendir(asset_dir);
+    if (!dir)
+    {
+        printf("Unable to open asset directory %s\n", asset_dir);
+        return 1;
+    }
+    struct dirent *dirent;
+    while ((dirent = readdir(dir)) != NULL)
+    {
+        if (!has_png_extension(dirent->d_name))
+            continue;
+        if (strlen(dirent->d_name) >= ASSET_PACK_NAME_LENGTH)
+        {
+            printf("Skipping %s, name too long\n", dirent->d_name);
+            continue;
+        }
+        if (name_count >= MAX_PACK_IMAGES)
+        {
+            printf("Too many images, only the first %d are packed\n", MAX_PACK_IMAGES);
+            break;
+        }
+        strcpy(names[name_count++], dirent->d_name);
+    }
+    closedir(dir);
+    qsort(names, name_count, ASSET_PACK_NAME_LENGTH, compare_names);
+
+    // Decode everything up front so the index can be written first
+    static SDL_Surface *surfaces[MAX_PACK_IMAGES];
+    static AssetPackEntry entries[MAX_PACK_IMAGES];
+    int entry_count = 0;
+    uint64_t offset = align_up(sizeof(AssetPackHeader) + sizeof(AssetPackEntry) * name_count);
+
+    for (int i = 0; i < name_count; i++)
+    {
+        char path[1024];
+        int length = snprintf(path, sizeof(path), "%s/%s", asset_dir, names[i]);
+        if (length < 0 || (size_t)length >= sizeof(path))
+        {
+            printf("Skipping %s, path too long\n", names[i]);
+            continue;
+        }
+
+        struct stat st;
+        if (stat(path, &st) != 0)
+        {
+            printf("Unable to stat image %s\n", path);
+            continue;
+        }
+
+        SDL_Surface *loaded = IMG_Load(path);
+        if (!loaded)
+        {
+            printf("Unable to load image %s! SDL_image Error: %s\n", path, IMG_GetError());
+            continue;
+        }
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(loaded);
+        if (!converted)
+        {
+            printf("Unable to convert image %s! SDL Error: %s\n", path, SDL_GetError());
+            continue;
+        }
+
+        AssetPackEntry *entry = &entries[entry_count];
+        memset(entry, 0, sizeof(AssetPackEntry));
+        strcpy(entry->name, names[i]);
+        entry->width = converted->w;
+        entry->height = converted->h;
+        entry->pitch = converted->w * 4;
+        entry->offset = offset;
+        entry->size = (uint64_t)entry->pitch * entry->height;
+        entry->source_mtime = (int64_t)st.st_mtime;
+        entry->source_size = (uint64_t)st.st_size;
+        offset = align_up(offset + entry->size);
+
+        surfaces[entry_count++] = converted;
+        printf("Packed %s (%dx%d)\n", names[i], converted->w, converted->h);
+    }
+
+    FILE *file = fopen(output_path, "wb");
+    if (!file)
+    {
+        printf("Unable to open %s for writing\n", output_path);
+        return 1;
+    }
+
+    AssetPackHeader header = {ASSET_PACK_MAGIC, ASSET_PACK_VERSION, (uint32_t)entry_count, 0};
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(entries, sizeof(AssetPackEntry), entry_count, file);
+
+    // Pixel data, rows written tightly packed at their aligned offsets
+    uint64_t written = sizeof(AssetPackHeader) + sizeof(AssetPackEntry) * entry_count;
+    for (int i = 0; i < entry_count; i++)
+    {
+        write_padding(file, entries[i].offset - written);
+        for (int y = 0; y < surfaces[i]->h; y++)
+        {
+            fwrite((uint8_t *)surfaces[i]->pixels + y * surfaces[i]->pitch, 1, entries[i].pitch, file);
+        }
+        written = entries[i].offset + entries[i].size;
+        SDL_FreeSurface(surfaces[i]);
+    }
+
+    fclose(file);
+    IMG_Quit();
+    printf("Wrote %d images to %s\n", entry_count, output_path);
+    return 0;
+}
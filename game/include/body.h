@@ -7,7 +7,33 @@ typedef struct {
     float scale;
     float speed;
     float vx, vy;
+    float radius;   // collision circle, in pixels
     int sprite_id;
+    float prev_x, prev_y; // state at the start of the last simulation step
+    float prev_rotation;
 } Body;
 
-#endif
\ No newline at end of file
+// Snapshot the current state before advancing the simulation
+static inline void body_store_previous(Body *body)
+{
+    body->prev_x = body->x;
+    body->prev_y = body->y;
+    body->prev_rotation = body->rotation;
+}
+
+// Blend between the last two simulation states for rendering (alpha in [0, 1])
+static inline void body_interpolate(const Body *body, float alpha, float *x, float *y, float *rotation)
+{
+    *x = body->prev_x + (body->x - body->prev_x) * alpha;
+    *y = body->prev_y + (body->y - body->prev_y) * alpha;
+
+    // Take the short way round when the angle wraps
+    float delta = body->rotation - body->prev_rotation;
+    while (delta > 180.0f)
+        delta -= 360.0f;
+    while (delta < -180.0f)
+        delta += 360.0f;
+    *rotation = body->prev_rotation + delta * alpha;
+}
+
+#endif
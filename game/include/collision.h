@@ -0,0 +1,33 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <stdint.h>
+#include "levels.h"
+#include "body.h"
+#include "engine.h"
+
+// Bodies are circles moving through the tile grid. Walls and the area outside the
+// map are solid; radii must stay below half a tile so bodies fit one-tile corridors.
+
+#define COLLISION_DEFAULT_RADIUS (TILE_SIZE * 0.375f)
+#define COLLISION_MAX_ADVANCES 8 // free-space jumps before switching to contact stepping
+#define COLLISION_BATCH_GRAIN 512 // bodies per parallel work item in collision_move_batch
+
+// Chebyshev distance, in tiles, from every tile to the nearest solid tile
+// (0 on walls, 1 next to one). Rebuild whenever walkability changes.
+typedef struct {
+    int width, height;
+    uint8_t *distance;
+} CollisionField;
+
+CollisionField *collision_field_create(const Map *map);
+void collision_field_destroy(CollisionField *field);
+void collision_field_rebuild(CollisionField *field, const Map *map);
+
+int collision_circle_blocked(const CollisionField *field, float x, float y, float radius);
+void collision_move(const CollisionField *field, float *x, float *y, float radius, float dx, float dy);
+void collision_move_batch(const CollisionField *field, float *x, float *y, const float *dx, const float *dy,
+                          const float *radius, int count);
+void collision_move_body(const CollisionField *field, Body *body, float timestep);
+
+#endif
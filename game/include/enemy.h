@@ -1,18 +1,32 @@
 #ifndef ENEMY_H
 #define ENEMY_H
 
-#include "body.h"
 #include <SDL2/SDL.h>
 #include "engine.h"
+#include "collision.h"
+#include "entity.h"
+#include "spatial_hash.h"
+#include "pathfind.h"
+#include "flow_field.h"
 
-typedef struct Enemy {
-    Body body;
-    int health;
-    int mana;
-    int level;
-} Enemy;
+#define ENEMY_SPEED 150.0f      // pixels per second
+#define ENEMY_JOB_GRAIN 512     // enemies per parallel work item
+#define ENEMY_MAX_NEIGHBOURS 32 // overlaps considered per enemy when separating
+#define ENEMY_CHASE_RADIUS (TILE_SIZE * 40.0f) // enemies this close to the player path towards it
+#define ENEMY_REPATH_TICKS 30                   // how often a chaser asks for a fresh path
+#define ENEMY_PATH_BUDGET 4000                  // search nodes per tick shared by all chasers
+#define ENEMY_WAYPOINT_REACH 2.0f               // pixels from a path point that count as there
+#define ENEMY_SPAWN_CLEARANCE (TILE_SIZE * 12.0f) // no enemies this close to the player spawn
 
-void enemy_init(Enemy *enemy, float x, float y);
-void enemy_update(Enemy *enemy, float timestep, Map *map);
+EntityHandle enemy_spawn(EntityStore *store, float x, float y);
+int enemy_pick_spawns(const CollisionField *collision, uint32_t seed, int count, float avoid_x, float avoid_y,
+                      float avoid_radius, float *x, float *y);
+void enemy_system_plan(EntityStore *store, Pathfinder *pathfinder, const FlowField *flow, const SpatialHash *hash,
+                       float target_x, float target_y);
+void enemy_system_update(EntityStore *store, float timestep, const CollisionField *collision,
+                         const Pathfinder *pathfinder, const FlowField *flow);
+void enemy_system_separate(EntityStore *store, SpatialHash *hash, const CollisionField *collision);
+void enemy_system_submit(const EntityStore *store, Camera *camera, float alpha, int layer);
+void enemy_system_shutdown();
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,57 @@
+#ifndef ENTITY_H
+#define ENTITY_H
+
+#include <stdint.h>
+#include "pathfind.h"
+
+// Struct-of-arrays storage for many bodies. Live entities are packed densely in
+// [0, count) so systems run straight loops over each component array; removal swaps
+// the last entity into the hole. Handles stay valid across that shuffle and go stale
+// once their entity is destroyed (the slot's generation moves on).
+
+#define ENTITY_INITIAL_CAPACITY 1024
+
+typedef struct {
+    uint32_t slot;
+    uint32_t generation;
+} EntityHandle;
+
+typedef struct {
+    int count;
+    int capacity;
+
+    // Dense components, index i belongs to the same entity in every array
+    float *x, *y;
+    float *prev_x, *prev_y; // state at the start of the last simulation step
+    float *vx, *vy;
+    float *rotation, *prev_rotation;
+    float *scale;
+    float *speed;
+    float *radius;
+    int *sprite_id;
+    int *health;
+    uint32_t *rng_id; // keys the entity's random stream
+    uint32_t *tick;   // simulation steps taken, the stream counter
+    PathHandle *path; // path being followed, slot -1 for none
+    int *path_index;  // next point of that path
+    uint32_t *slot_of;
+
+    // Sparse slots behind the handles
+    int slot_capacity;
+    int *dense_of; // -1 when the slot is free
+    uint32_t *generation;
+    uint32_t *free_slots;
+    int free_count;
+    uint32_t next_rng_id;
+} EntityStore;
+
+int entity_store_init(EntityStore *store);
+void entity_store_free(EntityStore *store);
+void entity_store_clear(EntityStore *store);
+EntityHandle entity_create(EntityStore *store, float x, float y);
+void entity_destroy(EntityStore *store, EntityHandle handle);
+int entity_index(const EntityStore *store, EntityHandle handle);
+void entity_store_previous(EntityStore *store);
+void entity_store_translate(EntityStore *store, float dx, float dy);
+
+#endif
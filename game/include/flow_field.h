@@ -0,0 +1,37 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <stdint.h>
+#include "levels.h"
+#include "path_search.h"
+
+// Shared route to one target for any number of followers. A Dijkstra from the target
+// tile fills a square window around it with the cost to reach the target and, per
+// tile, the neighbour to step to next. It only reruns when the target changes tile or
+// a tile inside the window changes; sampling it is a table lookup.
+
+#define FLOW_FIELD_RADIUS 24 // tiles each way from the target
+#define FLOW_UNREACHED -1
+#define FLOW_AT_TARGET 8
+
+typedef struct {
+    const Map *map;
+    int radius;
+    int size; // window is size x size tiles
+    int origin_x, origin_y;
+    int target_x, target_y;
+    int valid;
+
+    uint32_t *cost;
+    int8_t *direction; // step to the next tile, FLOW_UNREACHED or FLOW_AT_TARGET
+    PathHeap open;
+} FlowField;
+
+FlowField *flow_field_create(const Map *map, int radius);
+void flow_field_destroy(FlowField *field);
+int flow_field_update(FlowField *field, int target_x, int target_y);
+void flow_field_invalidate_tile(FlowField *field, int x, int y);
+void flow_field_invalidate_all(FlowField *field);
+int flow_field_sample(const FlowField *field, float x, float y, float *next_x, float *next_y);
+
+#endif
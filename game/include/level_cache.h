@@ -0,0 +1,44 @@
+#ifndef LEVEL_CACHE_H
+#define LEVEL_CACHE_H
+
+#include <stdint.h>
+#include "levels.h"
+
+// On-disk cache of generated levels, one file per config under LEVEL_CACHE_DIR.
+//
+// Layout: LevelCacheHeader, then the cells either raw (width * height Cell records)
+// or run-length encoded as LevelCacheRun records, whichever is smaller.
+
+#define LEVEL_CACHE_MAGIC 0x4C56434Cu // "LCVL"
+#define LEVEL_CACHE_FORMAT 1
+#define LEVEL_CACHE_DIR "game/levels/cache"
+
+enum {
+    LEVEL_CACHE_RAW,
+    LEVEL_CACHE_RLE
+};
+
+typedef struct {
+    uint32_t magic;
+    uint16_t format;
+    uint16_t encoding;
+    uint32_t generator_version; // MAPGEN_VERSION that produced the cells
+    uint32_t config_hash;
+    uint32_t seed;
+    int32_t width, height;
+    uint32_t payload_size; // bytes after the header
+    uint32_t checksum;     // FNV-1a over the decoded cells
+    uint32_t reserved;
+} LevelCacheHeader;
+
+typedef struct {
+    uint16_t count;
+    Cell cell;
+} LevelCacheRun;
+
+uint32_t level_config_hash(const LevelConfig *config);
+Map *level_cache_load(const LevelConfig *config);
+int level_cache_save(const LevelConfig *config, const Map *map);
+Map *level_cache_load_or_generate(const LevelConfig *config);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef LEVEL_MANAGER_H
+#define LEVEL_MANAGER_H
+
+#include <SDL2/SDL.h>
+#include "levels.h"
+#include "collision.h"
+#include "pathfind.h"
+#include "flow_field.h"
+
+// Everything derived from one map that the simulation needs. The next level's is
+// built whole on the generator thread and swapped in at once.
+typedef struct {
+    Map *map;
+    CollisionField *collision;
+    Pathfinder *pathfinder;
+    FlowField *chase_field;
+    float spawn_x, spawn_y; // player start
+    float *enemy_x, *enemy_y;
+    int enemy_count;        // enemy starts found, up to the manager's enemy_count
+} LevelData;
+
+// Owns the level being played and generates the next one on a background thread,
+// so walking through the exit door swaps maps without stalling the frame.
+typedef struct {
+    int level_number;
+    LevelConfig config;
+    LevelData current;
+    int enemy_count; // enemies placed on each level
+
+    int next_level_number;
+    LevelConfig next_config;
+    LevelData next;         // written by the generator thread, read once next_ready is set
+    int next_failed;
+    SDL_Thread *next_thread;
+    SDL_atomic_t next_ready;
+} LevelManager;
+
+int level_manager_init(LevelManager *manager, int first_level, int enemy_count);
+int level_manager_try_advance(LevelManager *manager, float player_x, float player_y);
+void level_manager_shutdown(LevelManager *manager);
+
+#endif
@@ -22,10 +22,21 @@ typedef struct {
     uint8_t tile_type;
 } Cell;
 
+// Tiles are stored in 8x8 blocks (block rows left to right, then tiles row-major inside
+// each block) so neighbours in both directions share cache lines. Walkability is kept
+// separately as one bit per tile, row-major, for collision and pathfinding scans.
+// Always write through set_cell so both stay in sync.
+#define MAP_BLOCK_SHIFT 3
+#define MAP_BLOCK_SIZE (1 << MAP_BLOCK_SHIFT)
+#define MAP_BLOCK_MASK (MAP_BLOCK_SIZE - 1)
+
 typedef struct {
     Cell *cells;
+    uint64_t *walkable;
     int width;
     int height;
+    int blocks_w;           // blocks per block row
+    int walk_words_per_row; // 64-bit words per walkability row
 } Map;
 
 typedef struct {
@@ -40,11 +51,33 @@ void generate_map(Map* map, uint32_t seed);
 void cleanup_map(Map* map);
 LevelConfig load_level_config(int level_number);
 
-static inline Cell* get_cell(Map* map, int x, int y) {
-    return &map->cells[y * map->width + x];
+static inline int map_cell_index(const Map *map, int x, int y) {
+    int block = (y >> MAP_BLOCK_SHIFT) * map->blocks_w + (x >> MAP_BLOCK_SHIFT);
+    return (block << (2 * MAP_BLOCK_SHIFT)) | ((y & MAP_BLOCK_MASK) << MAP_BLOCK_SHIFT) | (x & MAP_BLOCK_MASK);
+}
+
+static inline const Cell* get_cell(const Map* map, int x, int y) {
+    return &map->cells[map_cell_index(map, x, y)];
+}
+
+static inline int map_is_walkable(const Map *map, int x, int y) {
+    return (map->walkable[(size_t)y * map->walk_words_per_row + (x >> 6)] >> (x & 63)) & 1;
+}
+
+static inline void set_cell(Map *map, int x, int y, uint8_t flags, uint8_t tile_type) {
+    Cell *cell = &map->cells[map_cell_index(map, x, y)];
+    cell->flags = flags;
+    cell->tile_type = tile_type;
+
+    uint64_t *word = &map->walkable[(size_t)y * map->walk_words_per_row + (x >> 6)];
+    uint64_t bit = (uint64_t)1 << (x & 63);
+    if (flags & WALKABLE)
+        *word |= bit;
+    else
+        *word &= ~bit;
 }
 
-static inline int is_walkable(Cell* cell) {
+static inline int is_walkable(const Cell* cell) {
     return cell->flags & WALKABLE;
 }
 
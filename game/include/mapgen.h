@@ -0,0 +1,43 @@
+#ifndef MAPGEN_H
+#define MAPGEN_H
+
+#include <stdint.h>
+#include "levels.h"
+
+#define MAPGEN_BAND_ROWS 64 // rows per parallel work item
+
+// Bump whenever generate_map produces different cells for the same config,
+// cached levels from older generators are then regenerated
+#define MAPGEN_VERSION 2
+
+// Wall state for map generation, one bit per tile (set = wall).
+// Bit (x % 64) of word (x / 64) in each row; bits past the map width stay clear.
+typedef struct {
+    int width, height;
+    int words_per_row;
+    uint64_t *bits;
+} WallBitboard;
+
+int bitboard_init(WallBitboard *board, int width, int height);
+void bitboard_free(WallBitboard *board);
+void bitboard_fill_noise(WallBitboard *board, uint32_t seed, int wall_percent);
+void bitboard_smooth_rows(const WallBitboard *src, WallBitboard *dst, int row_start, int row_end);
+void bitboard_smooth(WallBitboard *board, WallBitboard *scratch, int iterations);
+void bitboard_to_cells(const WallBitboard *board, Map *map);
+
+static inline uint64_t *bitboard_row(const WallBitboard *board, int y)
+{
+    return &board->bits[(size_t)y * board->words_per_row];
+}
+
+static inline void bitboard_set_wall(WallBitboard *board, int x, int y)
+{
+    bitboard_row(board, y)[x >> 6] |= (uint64_t)1 << (x & 63);
+}
+
+static inline int bitboard_is_wall(const WallBitboard *board, int x, int y)
+{
+    return (bitboard_row(board, y)[x >> 6] >> (x & 63)) & 1;
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef PATH_GRAPH_H
+#define PATH_GRAPH_H
+
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include "levels.h"
+#include "path_search.h"
+
+// Abstract graph for hierarchical pathfinding (HPA*). The map is cut into square
+// clusters. Wherever open tiles face each other across a cluster border there is an
+// entrance: a node on each side, one straight step apart. Nodes of the same cluster are
+// joined by their shortest distance inside it. Long searches run over this graph, and
+// the pathfinder refines the result on the grid one cluster at a time.
+
+#define PATH_CLUSTER_SHIFT 4
+#define PATH_CLUSTER_SIZE (1 << PATH_CLUSTER_SHIFT)
+#define PATH_CLUSTER_MAX_NODES 32 // at most 8 entrances fit on a 16 tile border
+#define PATH_ENTRANCE_SPLIT 6     // openings at least this wide get an entrance at each end
+#define PATH_CLUSTER_STRIDE (PATH_CLUSTER_SIZE + 2)
+
+typedef enum {
+    PATH_SIDE_LEFT,
+    PATH_SIDE_RIGHT,
+    PATH_SIDE_TOP,
+    PATH_SIDE_BOTTOM
+} PathSide;
+
+typedef struct {
+    int16_t x, y;
+    uint8_t side;
+} PathGraphNode;
+
+typedef struct {
+    uint8_t a, b; // node indices within the cluster
+    uint32_t cost;
+} PathGraphEdge;
+
+typedef struct {
+    int node_count;
+    PathGraphNode nodes[PATH_CLUSTER_MAX_NODES];
+    int edge_count;
+    int edge_capacity;
+    PathGraphEdge *edges;
+} PathCluster;
+
+// Working copy of one cluster for searches that stay inside it. Walkability is copied
+// with a blocked border, so the search needs no bounds checks.
+typedef struct {
+    int min_x, min_y;
+    uint8_t open[PATH_CLUSTER_STRIDE * PATH_CLUSTER_STRIDE];
+    uint8_t wanted[PATH_CLUSTER_STRIDE * PATH_CLUSTER_STRIDE];
+    uint32_t distance[PATH_CLUSTER_STRIDE * PATH_CLUSTER_STRIDE];
+    PathHeap heap;
+} PathClusterScratch;
+
+typedef struct {
+    const Map *map;
+    int clusters_w, clusters_h;
+    PathCluster *clusters;
+    SDL_atomic_t failed; // set when a cluster could not be built; the graph is then unusable
+
+    // Search state per node id (cluster * PATH_CLUSTER_MAX_NODES + index); the two ids
+    // after the last cluster are the query's start and goal
+    int node_ids;
+    uint32_t *g;
+    int *parent;
+    uint32_t *stamp;
+    uint8_t *closed;
+    uint32_t query_stamp;
+    PathHeap open;
+
+    // Local searches for rebuilds and for joining a query to its clusters
+    PathClusterScratch local;
+    uint32_t start_cost[PATH_CLUSTER_MAX_NODES];
+    uint32_t goal_cost[PATH_CLUSTER_MAX_NODES];
+
+    // Tiles of the last path found: start, the entrances crossed, goal
+    PathGraphNode *route;
+    int route_count;
+    int route_capacity;
+} PathGraph;
+
+PathGraph *path_graph_create(const Map *map);
+void path_graph_destroy(PathGraph *graph);
+int path_graph_update_tile(PathGraph *graph, int x, int y);
+int path_graph_find(PathGraph *graph, int start_x, int start_y, int goal_x, int goal_y, int max_expansions,
+                    int *expansions);
+void path_graph_cluster_bounds(const PathGraph *graph, int x, int y, int *min_x, int *min_y, int *max_x, int *max_y);
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef PATH_SEARCH_H
+#define PATH_SEARCH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// Pieces shared by the grid and abstract path searches. Costs are fixed point, 1000 per
+// straight step, so diagonal and straight moves add up without rounding drift.
+
+#define PATH_COST_STRAIGHT 1000
+#define PATH_COST_DIAGONAL 1414
+#define PATH_UNREACHABLE UINT32_MAX
+
+// Cost of the best unobstructed 8-directional route, the heuristic for both searches
+static inline uint32_t path_octile(int x0, int y0, int x1, int y1)
+{
+    int dx = abs(x1 - x0);
+    int dy = abs(y1 - y0);
+    int diagonal = dx < dy ? dx : dy;
+    int straight = (dx > dy ? dx : dy) - diagonal;
+    return (uint32_t)(diagonal * PATH_COST_DIAGONAL + straight * PATH_COST_STRAIGHT);
+}
+
+// Binary min-heap of (priority, node). Entries are never updated in place: a node found
+// cheaper is pushed again and the stale copy skipped when popped. The buffer is kept
+// between searches and only ever grows.
+
+typedef struct {
+    uint32_t f;
+    int node;
+} PathHeapEntry;
+
+typedef struct {
+    PathHeapEntry *entries;
+    int count;
+    int capacity;
+} PathHeap;
+
+static inline int path_heap_push(PathHeap *heap, uint32_t f, int node)
+{
+    if (heap->count == heap->capacity)
+    {
+        int new_capacity = heap->capacity > 0 ? heap->capacity * 2 : 1024;
+        PathHeapEntry *grown = (PathHeapEntry *)realloc(heap->entries, sizeof(PathHeapEntry) * new_capacity);
+        if (!grown)
+            return -1;
+        heap->entries = grown;
+        heap->capacity = new_capacity;
+    }
+
+    int i = heap->count++;
+    while (i > 0)
+    {
+        int up = (i - 1) / 2;
+        if (heap->entries[up].f <= f)
+            break;
+        heap->entries[i] = heap->entries[up];
+        i = up;
+    }
+    heap->entries[i].f = f;
+    heap->entries[i].node = node;
+    return 0;
+}
+
+static inline int path_heap_pop(PathHeap *heap)
+{
+    int node = heap->entries[0].node;
+    PathHeapEntry last = heap->entries[--heap->count];
+
+    int i = 0;
+    while (1)
+    {
+        int child = i * 2 + 1;
+        if (child >= heap->count)
+            break;
+        if (child + 1 < heap->count && heap->entries[child + 1].f < heap->entries[child].f)
+            child++;
+        if (last.f <= heap->entries[child].f)
+            break;
+        heap->entries[i] = heap->entries[child];
+        i = child;
+    }
+    if (heap->count > 0)
+        heap->entries[i] = last;
+    return node;
+}
+
+#endif
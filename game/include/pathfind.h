@@ -0,0 +1,79 @@
+#ifndef PATHFIND_H
+#define PATHFIND_H
+
+#include <stdint.h>
+#include "levels.h"
+#include "path_search.h"
+#include "path_graph.h"
+
+// Jump Point Search over the map's walkability bits. Moves are 8-directional, and a
+// diagonal step needs both orthogonal neighbours open so bodies never clip corners.
+// Results live in a cache keyed by start and goal tile; callers hold a PathHandle and
+// look the path up again each use, so evicted or invalidated paths are noticed.
+// Queries longer than PATH_HIERARCHY_DISTANCE go over the cluster graph first and are
+// refined on the grid cluster by cluster, only as far as the path buffer reaches.
+
+#define PATH_MAX_POINTS 64            // jump points kept per path; longer paths are cut short
+#define PATH_CACHE_SIZE 1024          // direct-mapped entries, power of two
+#define PATH_MAX_EXPANSIONS 20000     // per request, bounds the worst case on huge maps
+#define PATH_HIERARCHY_DISTANCE (PATH_CLUSTER_SIZE * 2 * PATH_COST_STRAIGHT) // octile cost
+
+typedef enum {
+    PATH_FOUND,
+    PATH_NOT_FOUND,
+    PATH_DEFERRED // frame budget used up, ask again next frame
+} PathStatus;
+
+typedef struct {
+    int16_t x, y;
+} PathPoint;
+
+typedef struct {
+    int start_x, start_y, goal_x, goal_y;
+    uint32_t generation; // bumped whenever the entry is replaced or invalidated
+    int valid;
+    int found;
+    int min_x, min_y, max_x, max_y; // bounds of the whole path, for invalidation
+    int count;
+    PathPoint points[PATH_MAX_POINTS]; // jump points from start to goal, straight or diagonal between
+} PathCacheEntry;
+
+typedef struct {
+    int slot;
+    uint32_t generation;
+} PathHandle;
+
+typedef struct {
+    const Map *map;
+    int width, height;
+
+    // Per-tile search state, reset lazily by stamping instead of clearing
+    uint32_t *g;
+    int *parent;
+    uint32_t *stamp;
+    uint8_t *closed;
+    uint32_t query_stamp;
+
+    PathHeap open; // reused by every query
+
+    // Current grid search: goal and the inclusive window it may not leave
+    int goal_x, goal_y;
+    int min_x, min_y, max_x, max_y;
+
+    int frame_budget;
+    int frame_expansions;
+
+    PathCacheEntry *cache;
+    PathGraph *graph; // NULL if it could not be built
+} Pathfinder;
+
+Pathfinder *pathfinder_create(const Map *map);
+void pathfinder_destroy(Pathfinder *pf);
+void pathfinder_begin_frame(Pathfinder *pf, int expansion_budget);
+PathStatus pathfinder_request(Pathfinder *pf, int start_x, int start_y, int goal_x, int goal_y, PathHandle *handle);
+const PathCacheEntry *pathfinder_get(const Pathfinder *pf, PathHandle handle);
+void pathfinder_invalidate_tile(Pathfinder *pf, int x, int y);
+void pathfinder_invalidate_all(Pathfinder *pf);
+void pathfinder_rebuild(Pathfinder *pf, int build_graph);
+
+#endif
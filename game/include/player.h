@@ -4,6 +4,7 @@
 #include "body.h"
 #include <SDL2/SDL.h>
 #include "engine.h"
+#include "collision.h"
 
 typedef struct Player {
     Body body;
@@ -14,7 +15,6 @@ typedef struct Player {
 } Player;
 
 void player_init(Player *player, float x, float y);
-void player_update(Player *player, float timestep, Camera *camera, Map *map);
-int can_move_to_with_size(Map *map, float x, float y, float player_radius);
+void player_update(Player *player, float timestep, Camera *camera, const CollisionField *collision);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Stateless counter-based random numbers: every value is a hash of (seed, stream, a, b),
+// so results don't depend on call order and can be computed from any thread.
+
+// Streams keep different uses of the same seed independent
+#define RNG_STREAM_MAP_NOISE 1
+#define RNG_STREAM_MAP_DECOR 2
+#define RNG_STREAM_ENEMY_WALK 3
+#define RNG_STREAM_ENEMY_SPAWN 4
+
+// SplitMix64 finalizer
+static inline uint64_t rng_mix64(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline uint32_t rng_u32(uint32_t seed, uint32_t stream, uint32_t a, uint32_t b)
+{
+    uint64_t key = rng_mix64(((uint64_t)seed << 32 | stream) + 0x9E3779B97F4A7C15ull);
+    return (uint32_t)(rng_mix64(key ^ ((uint64_t)a << 32 | b)) >> 32);
+}
+
+// Uniform integer in [0, n) from a random value
+static inline int rng_range(uint32_t value, int n)
+{
+    return (int)(((uint64_t)value * (uint32_t)n) >> 32);
+}
+
+#endif
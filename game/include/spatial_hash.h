@@ -0,0 +1,39 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <stdint.h>
+#include "engine.h"
+
+// Uniform grid broadphase over point positions, with grid cells hashed into a bucket
+// table so the world needs no fixed bounds. Rebuilt from scratch every fixed tick with
+// a counting sort; queries return indices into the arrays passed to spatial_hash_build.
+
+#define SPATIAL_CELL_SIZE (TILE_SIZE * 4)
+#define SPATIAL_MIN_BUCKETS 64
+
+typedef struct {
+    float cell_size;
+    float inv_cell_size;
+    int count;
+    int capacity;
+    int bucket_mask;   // bucket count - 1 (power of two)
+    int *bucket_start; // bucket_mask + 2 prefix sums into the sorted arrays
+
+    // Entries sorted by bucket, positions copied alongside for locality
+    int *index;
+    float *x, *y;
+    int *cell_x, *cell_y; // filters out other cells sharing a bucket
+
+    int *entry_bucket; // scratch for the build
+} SpatialHash;
+
+typedef void (*SpatialPairFn)(void *userdata, int a, int b, float distance_sq);
+
+SpatialHash *spatial_hash_create(float cell_size);
+void spatial_hash_destroy(SpatialHash *hash);
+int spatial_hash_build(SpatialHash *hash, const float *x, const float *y, int count);
+int spatial_hash_query_radius(const SpatialHash *hash, float x, float y, float radius, int *out, int max_out);
+int spatial_hash_nearest(const SpatialHash *hash, float x, float y, float max_radius, int exclude);
+void spatial_hash_for_each_pair(const SpatialHash *hash, float radius, SpatialPairFn fn, void *userdata);
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include "levels.h"
+
+// Unbounded world made of fixed-size chunks, generated on worker threads around a
+// focus point and evicted least-recently-used once the resident budget is full.
+// Systems that read a Map (collision, pathfinding, the tile cache) see it through a
+// WorldView: a Map covering the chunks around the focus, moved a whole chunk at a time.
+
+#define WORLD_CHUNK_SIZE 64    // tiles per chunk side
+#define WORLD_MAX_CHUNKS 256   // resident chunk budget, bounds memory
+#define WORLD_LOAD_RADIUS 3    // chunks kept around the focus point in each direction
+#define WORLD_GEN_THREADS 2
+#define WORLD_BUCKETS 512      // chunk lookup hash buckets (power of two)
+#define WORLD_VIEW_CHUNKS (2 * WORLD_LOAD_RADIUS + 1)             // view side, in chunks
+#define WORLD_VIEW_TILES (WORLD_VIEW_CHUNKS * WORLD_CHUNK_SIZE)  // view side, in tiles
+
+// world_view_update results
+#define WORLD_VIEW_MOVED 1  // the view was re-centred; positions shift by the returned tiles
+#define WORLD_VIEW_FILLED 2 // newly generated chunks were copied in
+
+enum {
+    CHUNK_EMPTY,
+    CHUNK_QUEUED, // owned by a generator thread until READY
+    CHUNK_READY
+};
+
+typedef struct {
+    int chunk_x, chunk_y;
+    SDL_atomic_t state;
+    Uint32 last_used; // world frame that last needed this chunk
+    int next;         // next slot in the same hash bucket, -1 at the end
+    Cell cells[WORLD_CHUNK_SIZE * WORLD_CHUNK_SIZE];
+} WorldChunk;
+
+typedef struct {
+    uint32_t seed;
+    Uint32 frame;
+    WorldChunk *chunks;
+    int buckets[WORLD_BUCKETS]; // head slot per bucket, -1 if empty
+
+    // Generation queue of slot indices
+    SDL_Thread *threads[WORLD_GEN_THREADS];
+    int thread_count;
+    SDL_mutex *queue_mutex;
+    SDL_cond *queue_cond;
+    int queue[WORLD_MAX_CHUNKS];
+    int queue_head, queue_count;
+    int stopping;
+} World;
+
+// Map tile (x, y) is world tile (origin_x + x, origin_y + y). Chunks that aren't
+// generated yet read as walls until they are copied in.
+typedef struct {
+    Map *map;
+    int center_x, center_y; // chunk in the middle of the view
+    int origin_x, origin_y;
+    uint8_t filled[WORLD_VIEW_CHUNKS * WORLD_VIEW_CHUNKS];
+    int filled_count;
+} WorldView;
+
+World *world_create(uint32_t seed);
+void world_destroy(World *world);
+void world_update(World *world, float focus_x, float focus_y);
+const Cell *world_get_cell(World *world, int x, int y);
+int world_is_walkable(World *world, int x, int y);
+
+int world_view_init(WorldView *view, int tile_x, int tile_y);
+void world_view_free(WorldView *view);
+int world_view_update(WorldView *view, World *world, float focus_x, float focus_y, int *shift_x, int *shift_y);
+
+#endif
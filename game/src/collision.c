@@ -0,0 +1,247 @@
+#include "collision.h"
+#include "job_system.h"
+#include <math.h>
+#include <string.h>
+
+CollisionField *collision_field_create(const Map *map)
+{
+    CollisionField *field = (CollisionField *)malloc(sizeof(CollisionField));
+    if (!field)
+        return NULL;
+
+    field->width = map->width;
+    field->height = map->height;
+    field->distance = (uint8_t *)malloc((size_t)map->width * map->height);
+    if (!field->distance)
+    {
+        free(field);
+        return NULL;
+    }
+
+    collision_field_rebuild(field, map);
+    return field;
+}
+
+void collision_field_destroy(CollisionField *field)
+{
+    if (field)
+    {
+        free(field->distance);
+        free(field);
+    }
+}
+
+static int min_int(int a, int b)
+{
+    return a < b ? a : b;
+}
+
+// Two-pass chamfer transform with unit weights on all 8 neighbours, which gives the
+// exact Chebyshev distance. Tiles past the map edge count as walls.
+void collision_field_rebuild(CollisionField *field, const Map *map)
+{
+    int width = field->width;
+    int height = field->height;
+    uint8_t *dist = field->distance;
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            if (!map_is_walkable(map, x, y))
+            {
+                dist[y * width + x] = 0;
+                continue;
+            }
+
+            int d = 255;
+            if (x == 0 || y == 0 || x == width - 1 || y == height - 1)
+                d = 1;
+            if (y > 0)
+            {
+                const uint8_t *up = &dist[(y - 1) * width + x];
+                d = min_int(d, up[0] + 1);
+                if (x > 0)
+                    d = min_int(d, up[-1] + 1);
+                if (x < width - 1)
+                    d = min_int(d, up[1] + 1);
+            }
+            if (x > 0)
+                d = min_int(d, dist[y * width + x - 1] + 1);
+            dist[y * width + x] = (uint8_t)min_int(d, 255);
+        }
+    }
+
+    for (int y = height - 1; y >= 0; y--)
+    {
+        for (int x = width - 1; x >= 0; x--)
+        {
+            int d = dist[y * width + x];
+            if (d <= 1)
+                continue;
+            if (y < height - 1)
+            {
+                const uint8_t *down = &dist[(y + 1) * width + x];
+                d = min_int(d, down[0] + 1);
+                if (x > 0)
+                    d = min_int(d, down[-1] + 1);
+                if (x < width - 1)
+                    d = min_int(d, down[1] + 1);
+            }
+            if (x < width - 1)
+                d = min_int(d, dist[y * width + x + 1] + 1);
+            dist[y * width + x] = (uint8_t)min_int(d, 255);
+        }
+    }
+}
+
+static int tile_solid(const CollisionField *field, int tile_x, int tile_y)
+{
+    if (tile_x < 0 || tile_x >= field->width || tile_y < 0 || tile_y >= field->height)
+        return 1;
+    return field->distance[tile_y * field->width + tile_x] == 0;
+}
+
+// Lower bound on the distance from (x, y) to any solid tile. A tile at distance d has
+// every tile within d - 1 of it open, so the open square around it bounds the answer.
+static float clearance(const CollisionField *field, float x, float y)
+{
+    int tile_x = (int)floorf(x / TILE_SIZE);
+    int tile_y = (int)floorf(y / TILE_SIZE);
+    if (tile_solid(field, tile_x, tile_y))
+        return 0.0f;
+
+    int d = field->distance[tile_y * field->width + tile_x];
+    float left = x - (tile_x - d + 1) * TILE_SIZE;
+    float right = (tile_x + d) * TILE_SIZE - x;
+    float top = y - (tile_y - d + 1) * TILE_SIZE;
+    float bottom = (tile_y + d) * TILE_SIZE - y;
+    return fminf(fminf(left, right), fminf(top, bottom));
+}
+
+// Exact circle-vs-tile test against every tile the circle's bounds touch
+int collision_circle_blocked(const CollisionField *field, float x, float y, float radius)
+{
+    int min_x = (int)floorf((x - radius) / TILE_SIZE);
+    int max_x = (int)floorf((x + radius) / TILE_SIZE);
+    int min_y = (int)floorf((y - radius) / TILE_SIZE);
+    int max_y = (int)floorf((y + radius) / TILE_SIZE);
+
+    for (int tile_y = min_y; tile_y <= max_y; tile_y++)
+    {
+        for (int tile_x = min_x; tile_x <= max_x; tile_x++)
+        {
+            if (!tile_solid(field, tile_x, tile_y))
+                continue;
+
+            float near_x = fmaxf(tile_x * TILE_SIZE, fminf(x, (tile_x + 1) * TILE_SIZE));
+            float near_y = fmaxf(tile_y * TILE_SIZE, fminf(y, (tile_y + 1) * TILE_SIZE));
+            float ox = x - near_x;
+            float oy = y - near_y;
+            if (ox * ox + oy * oy < radius * radius)
+                return 1;
+        }
+    }
+    return 0;
+}
+
+// Move along one axis as far as possible up to the full step, by bisection on contact
+static float slide_axis(const CollisionField *field, float x, float y, float radius, float step, int along_x)
+{
+    if (!collision_circle_blocked(field, along_x ? x + step : x, along_x ? y : y + step, radius))
+        return step;
+
+    float lo = 0.0f, hi = 1.0f;
+    for (int i = 0; i < 6; i++)
+    {
+        float mid = (lo + hi) * 0.5f;
+        if (collision_circle_blocked(field, along_x ? x + step * mid : x, along_x ? y : y + step * mid, radius))
+            hi = mid;
+        else
+            lo = mid;
+    }
+    return step * lo;
+}
+
+// Swept move of a circle by (dx, dy). Open space is crossed in a few jumps sized by the
+// distance field; near walls the rest of the move is stepped per axis so bodies slide.
+// A body that starts inside a wall moves freely until it is out.
+void collision_move(const CollisionField *field, float *x, float *y, float radius, float dx, float dy)
+{
+    float length = sqrtf(dx * dx + dy * dy);
+    if (length <= 0.0f)
+        return;
+
+    if (collision_circle_blocked(field, *x, *y, radius))
+    {
+        *x += dx;
+        *y += dy;
+        return;
+    }
+
+    float dir_x = dx / length;
+    float dir_y = dy / length;
+    float remaining = length;
+
+    for (int i = 0; i < COLLISION_MAX_ADVANCES && remaining > 0.0f; i++)
+    {
+        float clear_distance = clearance(field, *x, *y) - radius;
+        if (clear_distance >= remaining)
+        {
+            *x += dir_x * remaining;
+            *y += dir_y * remaining;
+            return;
+        }
+        if (clear_distance < TILE_SIZE * 0.05f)
+            break;
+
+        *x += dir_x * clear_distance;
+        *y += dir_y * clear_distance;
+        remaining -= clear_distance;
+    }
+
+    // Contact: steps of at most half a radius can't skip over a whole tile
+    float max_step = fmaxf(radius * 0.5f, 0.5f);
+    int steps = (int)ceilf(remaining / max_step);
+    float step_x = dir_x * remaining / steps;
+    float step_y = dir_y * remaining / steps;
+    for (int i = 0; i < steps; i++)
+    {
+        float moved_x = slide_axis(field, *x, *y, radius, step_x, 1);
+        *x += moved_x;
+        float moved_y = slide_axis(field, *x, *y, radius, step_y, 0);
+        *y += moved_y;
+        if (moved_x == 0.0f && moved_y == 0.0f)
+            break;
+    }
+}
+
+typedef struct {
+    const CollisionField *field;
+    float *x, *y;
+    const float *dx, *dy;
+    const float *radius;
+} MoveBatch;
+
+static void move_batch_range(void *userdata, int begin, int end)
+{
+    MoveBatch *batch = (MoveBatch *)userdata;
+    for (int i = begin; i < end; i++)
+    {
+        collision_move(batch->field, &batch->x[i], &batch->y[i], batch->radius[i], batch->dx[i], batch->dy[i]);
+    }
+}
+
+// Resolve many bodies in one call, e.g. straight from struct-of-arrays entity storage.
+// Bodies don't interact here, so the batch is split across the job system.
+void collision_move_batch(const CollisionField *field, float *x, float *y, const float *dx, const float *dy,
+                          const float *radius, int count)
+{
+    MoveBatch batch = {field, x, y, dx, dy, radius};
+    job_parallel_for(count, COLLISION_BATCH_GRAIN, move_batch_range, &batch);
+}
+
+void collision_move_body(const CollisionField *field, Body *body, float timestep)
+{
+    collision_move(field, &body->x, &body->y, body->radius, body->vx * timestep, body->vy * timestep);
+}
@@ -1,80 +1,367 @@
-#include "player.h"
 #include <SDL2/SDL.h>
 #include <math.h>
 #include "engine.h"
 #include "enemy.h"
+#include "rng.h"
+#include "job_system.h"
 
-void enemy_init(Enemy *enemy, float x, float y)
+EntityHandle enemy_spawn(EntityStore *store, float x, float y)
 {
-    enemy->body.x = x;
-    enemy->body.y = y;
-    enemy->body.rotation = 0.0f;
-    enemy->body.scale = 1.0f;
-    enemy->body.speed = 150.0f; // pixels per second
-    enemy->body.vx = 0.0f;
-    enemy->body.vy = 0.0f;
-    enemy->body.sprite_id = 0;
-
-    enemy->health = 100;
-    enemy->mana = 50;
-    enemy->level = 1;
+    EntityHandle handle = entity_create(store, x, y);
+    int i = entity_index(store, handle);
+    if (i >= 0)
+    {
+        store->speed[i] = ENEMY_SPEED;
+        store->sprite_id[i] = 0;
+    }
+    return handle;
 }
 
-void enemy_update(Enemy *enemy, float timestep, Map *map)
+// Pick up to count open tiles for enemies, keeping clear of (avoid_x, avoid_y), and
+// write their centres to x and y. Only reads the collision field, so it can run while
+// the level loads in the background. Returns how many were picked.
+int enemy_pick_spawns(const CollisionField *collision, uint32_t seed, int count, float avoid_x, float avoid_y,
+                      float avoid_radius, float *x, float *y)
 {
-    // Move randomly
-    float stepx = (rand() % 3 - 1); // -1, 0, or 1
-    float stepy = (rand() % 3 - 1);
-
-    // Normalize input and set velocity
-    if (stepx != 0 || stepy != 0)
+    int picked = 0;
+    for (int attempt = 0; picked < count && attempt < count * 20; attempt++)
     {
-        float length = sqrtf(stepx * stepx + stepy * stepy);
-        stepx /= length;
-        stepy /= length;
+        int tile_x = rng_range(rng_u32(seed, RNG_STREAM_ENEMY_SPAWN, attempt, 0), collision->width);
+        int tile_y = rng_range(rng_u32(seed, RNG_STREAM_ENEMY_SPAWN, attempt, 1), collision->height);
+        float spawn_x = tile_x * TILE_SIZE + TILE_SIZE / 2;
+        float spawn_y = tile_y * TILE_SIZE + TILE_SIZE / 2;
 
-        enemy->body.vx = stepx * enemy->body.speed;
-        enemy->body.vy = stepy * enemy->body.speed;
+        float dx = spawn_x - avoid_x;
+        float dy = spawn_y - avoid_y;
+        if (dx * dx + dy * dy < avoid_radius * avoid_radius)
+            continue;
+        if (collision_circle_blocked(collision, spawn_x, spawn_y, COLLISION_DEFAULT_RADIUS))
+            continue;
+
+        x[picked] = spawn_x;
+        y[picked] = spawn_y;
+        picked++;
     }
-    else
+    return picked;
+}
+
+// Scratch shared by the systems below, grown to the largest enemy count seen
+static float *push_x = NULL;
+static float *push_y = NULL;
+static RenderCommand *submit_cmds = NULL;
+static int *chasers = NULL;
+static int scratch_capacity = 0;
+
+static int reserve_scratch(int count)
+{
+    if (count <= scratch_capacity)
+        return 0;
+
+    int new_capacity = scratch_capacity > 0 ? scratch_capacity : ENTITY_INITIAL_CAPACITY;
+    while (new_capacity < count)
+        new_capacity *= 2;
+
+    float *grown_x = realloc(push_x, sizeof(float) * new_capacity);
+    if (grown_x)
+        push_x = grown_x;
+    float *grown_y = realloc(push_y, sizeof(float) * new_capacity);
+    if (grown_y)
+        push_y = grown_y;
+    RenderCommand *grown_cmds = realloc(submit_cmds, sizeof(RenderCommand) * new_capacity);
+    if (grown_cmds)
+        submit_cmds = grown_cmds;
+    int *grown_chasers = realloc(chasers, sizeof(int) * new_capacity);
+    if (grown_chasers)
+        chasers = grown_chasers;
+
+    if (!grown_x || !grown_y || !grown_cmds || !grown_chasers)
     {
-        enemy->body.vx = 0;
-        enemy->body.vy = 0;
+        printf("Unable to grow enemy system buffers!\n");
+        return -1;
     }
+    scratch_capacity = new_capacity;
+    return 0;
+}
+
+void enemy_system_shutdown()
+{
+    free(push_x);
+    free(push_y);
+    free(submit_cmds);
+    free(chasers);
+    push_x = NULL;
+    push_y = NULL;
+    submit_cmds = NULL;
+    chasers = NULL;
+    scratch_capacity = 0;
+}
+
+typedef struct {
+    EntityStore *store;
+    const CollisionField *collision;
+    const SpatialHash *hash;
+    float timestep;
+    float reach;
+    float alpha;
+    int layer;
+    const Pathfinder *pathfinder;
+    const FlowField *flow;
+} EnemyJob;
 
-    // Calculate new position
-    float new_x = enemy->body.x + enemy->body.vx * timestep;
-    float new_y = enemy->body.y + enemy->body.vy * timestep;
+// Give enemies near the target a path to its tile. Those inside the flow field follow
+// that instead and need no search of their own. Runs on the calling thread because
+// searches share the pathfinder's scratch; the update jobs only read cached paths.
+// Chasers ask again every ENEMY_REPATH_TICKS, staggered so they don't all ask on one
+// tick, and requests over the frame budget wait for a later tick.
+void enemy_system_plan(EntityStore *store, Pathfinder *pathfinder, const FlowField *flow, const SpatialHash *hash,
+                       float target_x, float target_y)
+{
+    if (reserve_scratch(store->count) != 0)
+        return;
+
+    int goal_x = (int)(target_x / TILE_SIZE);
+    int goal_y = (int)(target_y / TILE_SIZE);
+    int found = spatial_hash_query_radius(hash, target_x, target_y, ENEMY_CHASE_RADIUS, chasers, scratch_capacity);
+    if (found > scratch_capacity)
+        found = scratch_capacity;
 
-    // Check X movement collision
-    int tile_x = (int)(new_x / TILE_SIZE);
-    int tile_y = (int)(enemy->body.y / TILE_SIZE);
-    if (tile_x >= 0 && tile_x < map->width && tile_y >= 0 && tile_y < map->height)
+    for (int k = 0; k < found; k++)
     {
-        Cell *cell = get_cell(map, tile_x, tile_y);
-        if (is_walkable(cell))
+        int i = chasers[k];
+        if (i >= store->count)
+            continue; // the hash is from the previous tick
+
+        float next_x, next_y;
+        if (flow && flow_field_sample(flow, store->x[i], store->y[i], &next_x, &next_y))
         {
-            enemy->body.x = new_x;
+            store->path[i].slot = -1;
+            continue;
         }
-        if (!is_walkable(cell))
+
+        int following = pathfinder_get(pathfinder, store->path[i]) != NULL;
+        if (following && (store->tick[i] + store->rng_id[i]) % ENEMY_REPATH_TICKS != 0)
+            continue;
+
+        PathHandle handle;
+        PathStatus status = pathfinder_request(pathfinder, (int)(store->x[i] / TILE_SIZE),
+                                               (int)(store->y[i] / TILE_SIZE), goal_x, goal_y, &handle);
+        if (status == PATH_FOUND)
         {
-            enemy->body.x -= enemy->body.vx * timestep; // undo the step
+            store->path[i] = handle;
+            store->path_index[i] = 1; // point 0 is the tile the enemy stands on
         }
+        else if (status == PATH_NOT_FOUND)
+        {
+            store->path[i].slot = -1;
+        }
+    }
+}
+
+// Next point of the enemy's path, skipping points already reached. Returns 0 and
+// drops the path once it is finished or stale.
+static int next_waypoint(const EnemyJob *job, int i, float *target_x, float *target_y)
+{
+    EntityStore *store = job->store;
+    const PathCacheEntry *path = job->pathfinder ? pathfinder_get(job->pathfinder, store->path[i]) : NULL;
+
+    while (path && store->path_index[i] < path->count)
+    {
+        const PathPoint *point = &path->points[store->path_index[i]];
+        *target_x = point->x * TILE_SIZE + TILE_SIZE / 2;
+        *target_y = point->y * TILE_SIZE + TILE_SIZE / 2;
+        float dx = *target_x - store->x[i];
+        float dy = *target_y - store->y[i];
+        if (dx * dx + dy * dy > ENEMY_WAYPOINT_REACH * ENEMY_WAYPOINT_REACH)
+            return 1;
+        store->path_index[i]++;
+    }
+
+    store->path[i].slot = -1;
+    return 0;
+}
+
+// Head straight for a point at full speed, stopping on it rather than overshooting
+static void move_towards(const EnemyJob *job, int i, float target_x, float target_y)
+{
+    EntityStore *store = job->store;
+    float dx = target_x - store->x[i];
+    float dy = target_y - store->y[i];
+    float distance = sqrtf(dx * dx + dy * dy);
+    if (distance <= ENEMY_WAYPOINT_REACH)
+    {
+        store->vx[i] = 0.0f;
+        store->vy[i] = 0.0f;
+        return;
     }
 
-    // Check Y movement collision
-    tile_x = (int)(enemy->body.x / TILE_SIZE);
-    tile_y = (int)(new_y / TILE_SIZE);
-    if (tile_x >= 0 && tile_x < map->width && tile_y >= 0 && tile_y < map->height)
+    float dir_x = dx / distance;
+    float dir_y = dy / distance;
+    store->vx[i] = dir_x * store->speed[i];
+    store->vy[i] = dir_y * store->speed[i];
+
+    float step = store->speed[i] * job->timestep;
+    if (step > distance)
+        step = distance;
+    collision_move(job->collision, &store->x[i], &store->y[i], store->radius[i], dir_x * step, dir_y * step);
+}
+
+static void update_range(void *userdata, int begin, int end)
+{
+    EnemyJob *job = (EnemyJob *)userdata;
+    EntityStore *store = job->store;
+    const float inv_sqrt2 = 0.70710678f;
+
+    for (int i = begin; i < end; i++)
     {
-        Cell *cell = get_cell(map, tile_x, tile_y);
-        if (is_walkable(cell))
+        float target_x, target_y;
+        if ((job->flow && flow_field_sample(job->flow, store->x[i], store->y[i], &target_x, &target_y)) ||
+            next_waypoint(job, i, &target_x, &target_y))
         {
-            enemy->body.y = new_y;
+            store->tick[i]++;
+            move_towards(job, i, target_x, target_y);
+            continue;
         }
-        if (!is_walkable(cell))
+
+        // Move randomly, keyed by enemy and tick so other code drawing random numbers can't change it
+        float stepx = rng_range(rng_u32(store->rng_id[i], RNG_STREAM_ENEMY_WALK, store->tick[i], 0), 3) - 1.0f; // -1, 0, or 1
+        float stepy = rng_range(rng_u32(store->rng_id[i], RNG_STREAM_ENEMY_WALK, store->tick[i], 1), 3) - 1.0f;
+        store->tick[i]++;
+
+        // Normalize: diagonal steps are the only ones longer than 1
+        float scale = (stepx != 0.0f && stepy != 0.0f) ? inv_sqrt2 : 1.0f;
+        store->vx[i] = stepx * scale * store->speed[i];
+        store->vy[i] = stepy * scale * store->speed[i];
+
+        collision_move(job->collision, &store->x[i], &store->y[i], store->radius[i],
+                       store->vx[i] * job->timestep, store->vy[i] * job->timestep);
+    }
+}
+
+// Enemies inside the flow field follow it, those with a path follow that and the rest
+// wander. Each only touches its own components, so ranges run on any thread in any order.
+void enemy_system_update(EntityStore *store, float timestep, const CollisionField *collision,
+                         const Pathfinder *pathfinder, const FlowField *flow)
+{
+    EnemyJob job = {store, collision, NULL, timestep, 0.0f, 0.0f, 0, pathfinder, flow};
+    job_parallel_for(store->count, ENEMY_JOB_GRAIN, update_range, &job);
+}
+
+// Sum of the pushes away from every overlapping neighbour, half the overlap each
+static void gather_push_range(void *userdata, int begin, int end)
+{
+    EnemyJob *job = (EnemyJob *)userdata;
+    const EntityStore *store = job->store;
+    int neighbours[ENEMY_MAX_NEIGHBOURS];
+
+    for (int i = begin; i < end; i++)
+    {
+        float total_x = 0.0f, total_y = 0.0f;
+        int found = spatial_hash_query_radius(job->hash, store->x[i], store->y[i], job->reach,
+                                              neighbours, ENEMY_MAX_NEIGHBOURS);
+        if (found > ENEMY_MAX_NEIGHBOURS)
+            found = ENEMY_MAX_NEIGHBOURS;
+
+        for (int k = 0; k < found; k++)
         {
-            enemy->body.x -= enemy->body.vx * timestep; // undo the step
+            int j = neighbours[k];
+            if (j == i)
+                continue;
+
+            float min_distance = store->radius[i] + store->radius[j];
+            float dx = store->x[i] - store->x[j];
+            float dy = store->y[i] - store->y[j];
+            float distance_sq = dx * dx + dy * dy;
+            if (distance_sq >= min_distance * min_distance)
+                continue;
+
+            float distance = sqrtf(distance_sq);
+            float nx, ny;
+            if (distance > 0.0f)
+            {
+                nx = dx / distance;
+                ny = dy / distance;
+            }
+            else
+            {
+                // Stacked exactly on top of each other: split sideways, lower index to the left
+                nx = i < j ? -1.0f : 1.0f;
+                ny = 0.0f;
+            }
+            float push = (min_distance - distance) * 0.5f;
+            total_x += nx * push;
+            total_y += ny * push;
         }
+
+        push_x[i] = total_x;
+        push_y[i] = total_y;
+    }
+}
+
+// Pushes go through collision so nobody is shoved into a wall
+static void apply_push_range(void *userdata, int begin, int end)
+{
+    EnemyJob *job = (EnemyJob *)userdata;
+    EntityStore *store = job->store;
+
+    for (int i = begin; i < end; i++)
+    {
+        if (push_x[i] != 0.0f || push_y[i] != 0.0f)
+            collision_move(job->collision, &store->x[i], &store->y[i], store->radius[i], push_x[i], push_y[i]);
+    }
+}
+
+// Push overlapping enemies apart. Every push is computed from the positions before any
+// is applied, so the result doesn't depend on thread count or scheduling.
+void enemy_system_separate(EntityStore *store, SpatialHash *hash, const CollisionField *collision)
+{
+    if (reserve_scratch(store->count) != 0 || spatial_hash_build(hash, store->x, store->y, store->count) != 0)
+        return;
+
+    float max_radius = 0.0f;
+    for (int i = 0; i < store->count; i++)
+    {
+        if (store->radius[i] > max_radius)
+            max_radius = store->radius[i];
+    }
+
+    EnemyJob job = {store, collision, hash, 0.0f, max_radius * 2.0f, 0.0f, 0, NULL, NULL};
+    job_parallel_for(store->count, ENEMY_JOB_GRAIN, gather_push_range, &job);
+    job_parallel_for(store->count, ENEMY_JOB_GRAIN, apply_push_range, &job);
+}
+
+static void build_commands_range(void *userdata, int begin, int end)
+{
+    EnemyJob *job = (EnemyJob *)userdata;
+    const EntityStore *store = job->store;
+    float alpha = job->alpha;
+
+    for (int i = begin; i < end; i++)
+    {
+        // Take the short way round when the angle wraps
+        float delta = store->rotation[i] - store->prev_rotation[i];
+        while (delta > 180.0f)
+            delta -= 360.0f;
+        while (delta < -180.0f)
+            delta += 360.0f;
+
+        RenderCommand *cmd = &submit_cmds[i];
+        cmd->x = store->prev_x[i] + (store->x[i] - store->prev_x[i]) * alpha;
+        cmd->y = store->prev_y[i] + (store->y[i] - store->prev_y[i]) * alpha;
+        cmd->rotation = store->prev_rotation[i] + delta * alpha;
+        cmd->scale = store->scale[i];
+        cmd->sprite_id = store->sprite_id[i];
+        cmd->layer = job->layer;
     }
-}
\ No newline at end of file
+}
+
+// Queue every enemy for drawing, blended between the last two simulation states.
+// Commands are built in parallel and handed to the engine in one call.
+void enemy_system_submit(const EntityStore *store, Camera *camera, float alpha, int layer)
+{
+    if (reserve_scratch(store->count) != 0)
+        return;
+
+    EnemyJob job = {(EntityStore *)store, NULL, NULL, 0.0f, 0.0f, alpha, layer, NULL, NULL};
+    job_parallel_for(store->count, ENEMY_JOB_GRAIN, build_commands_range, &job);
+    engine_submit_world(camera, submit_cmds, store->count);
+}
@@ -0,0 +1,209 @@
+#include "entity.h"
+#include "collision.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ENTITY_INVALID_SLOT UINT32_MAX
+
+static int grow_array(void **array, size_t element_size, int capacity)
+{
+    void *grown = realloc(*array, element_size * capacity);
+    if (!grown)
+        return -1;
+    *array = grown;
+    return 0;
+}
+
+static int grow_dense(EntityStore *store)
+{
+    int new_capacity = store->capacity > 0 ? store->capacity * 2 : ENTITY_INITIAL_CAPACITY;
+
+    int failed = 0;
+    failed |= grow_array((void **)&store->x, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->y, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->prev_x, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->prev_y, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->vx, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->vy, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->rotation, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->prev_rotation, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->scale, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->speed, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->radius, sizeof(float), new_capacity);
+    failed |= grow_array((void **)&store->sprite_id, sizeof(int), new_capacity);
+    failed |= grow_array((void **)&store->health, sizeof(int), new_capacity);
+    failed |= grow_array((void **)&store->rng_id, sizeof(uint32_t), new_capacity);
+    failed |= grow_array((void **)&store->tick, sizeof(uint32_t), new_capacity);
+    failed |= grow_array((void **)&store->path, sizeof(PathHandle), new_capacity);
+    failed |= grow_array((void **)&store->path_index, sizeof(int), new_capacity);
+    failed |= grow_array((void **)&store->slot_of, sizeof(uint32_t), new_capacity);
+
+    failed |= grow_array((void **)&store->dense_of, sizeof(int), new_capacity);
+    failed |= grow_array((void **)&store->generation, sizeof(uint32_t), new_capacity);
+    failed |= grow_array((void **)&store->free_slots, sizeof(uint32_t), new_capacity);
+    if (failed)
+    {
+        printf("Unable to grow entity storage!\n");
+        return -1;
+    }
+
+    // Slots and dense entries grow together, so a free slot always exists afterwards
+    for (int slot = store->slot_capacity; slot < new_capacity; slot++)
+    {
+        store->dense_of[slot] = -1;
+        store->generation[slot] = 0;
+    }
+    for (int slot = new_capacity - 1; slot >= store->slot_capacity; slot--)
+        store->free_slots[store->free_count++] = slot;
+
+    store->capacity = new_capacity;
+    store->slot_capacity = new_capacity;
+    return 0;
+}
+
+int entity_store_init(EntityStore *store)
+{
+    memset(store, 0, sizeof(EntityStore));
+    return grow_dense(store);
+}
+
+void entity_store_free(EntityStore *store)
+{
+    free(store->x);
+    free(store->y);
+    free(store->prev_x);
+    free(store->prev_y);
+    free(store->vx);
+    free(store->vy);
+    free(store->rotation);
+    free(store->prev_rotation);
+    free(store->scale);
+    free(store->speed);
+    free(store->radius);
+    free(store->sprite_id);
+    free(store->health);
+    free(store->rng_id);
+    free(store->tick);
+    free(store->path);
+    free(store->path_index);
+    free(store->slot_of);
+    free(store->dense_of);
+    free(store->generation);
+    free(store->free_slots);
+    memset(store, 0, sizeof(EntityStore));
+}
+
+// Destroy every entity; outstanding handles all go stale
+void entity_store_clear(EntityStore *store)
+{
+    for (int i = store->count - 1; i >= 0; i--)
+    {
+        uint32_t slot = store->slot_of[i];
+        store->dense_of[slot] = -1;
+        store->generation[slot]++;
+        store->free_slots[store->free_count++] = slot;
+    }
+    store->count = 0;
+}
+
+EntityHandle entity_create(EntityStore *store, float x, float y)
+{
+    EntityHandle handle = {ENTITY_INVALID_SLOT, 0};
+    if (store->free_count == 0 && grow_dense(store) != 0)
+        return handle;
+
+    uint32_t slot = store->free_slots[--store->free_count];
+    int i = store->count++;
+    store->dense_of[slot] = i;
+    store->slot_of[i] = slot;
+
+    store->x[i] = x;
+    store->y[i] = y;
+    store->prev_x[i] = x;
+    store->prev_y[i] = y;
+    store->vx[i] = 0.0f;
+    store->vy[i] = 0.0f;
+    store->rotation[i] = 0.0f;
+    store->prev_rotation[i] = 0.0f;
+    store->scale[i] = 1.0f;
+    store->speed[i] = 0.0f;
+    store->radius[i] = COLLISION_DEFAULT_RADIUS;
+    store->sprite_id[i] = 0;
+    store->health[i] = 100;
+    store->rng_id[i] = store->next_rng_id++;
+    store->tick[i] = 0;
+    store->path[i].slot = -1;
+    store->path[i].generation = 0;
+    store->path_index[i] = 0;
+
+    handle.slot = slot;
+    handle.generation = store->generation[slot];
+    return handle;
+}
+
+// Dense index of a live entity, or -1 if the handle is stale
+int entity_index(const EntityStore *store, EntityHandle handle)
+{
+    if (handle.slot >= (uint32_t)store->slot_capacity || store->generation[handle.slot] != handle.generation)
+        return -1;
+    return store->dense_of[handle.slot];
+}
+
+void entity_destroy(EntityStore *store, EntityHandle handle)
+{
+    int i = entity_index(store, handle);
+    if (i < 0)
+        return;
+
+    // Move the last entity into the hole to keep the arrays packed
+    int last = --store->count;
+    if (i != last)
+    {
+        store->x[i] = store->x[last];
+        store->y[i] = store->y[last];
+        store->prev_x[i] = store->prev_x[last];
+        store->prev_y[i] = store->prev_y[last];
+        store->vx[i] = store->vx[last];
+        store->vy[i] = store->vy[last];
+        store->rotation[i] = store->rotation[last];
+        store->prev_rotation[i] = store->prev_rotation[last];
+        store->scale[i] = store->scale[last];
+        store->speed[i] = store->speed[last];
+        store->radius[i] = store->radius[last];
+        store->sprite_id[i] = store->sprite_id[last];
+        store->health[i] = store->health[last];
+        store->rng_id[i] = store->rng_id[last];
+        store->tick[i] = store->tick[last];
+        store->path[i] = store->path[last];
+        store->path_index[i] = store->path_index[last];
+        store->slot_of[i] = store->slot_of[last];
+        store->dense_of[store->slot_of[i]] = i;
+    }
+
+    store->dense_of[handle.slot] = -1;
+    store->generation[handle.slot]++;
+    store->free_slots[store->free_count++] = handle.slot;
+}
+
+// Snapshot every entity before advancing the simulation, as body_store_previous does
+void entity_store_previous(EntityStore *store)
+{
+    int count = store->count;
+    memcpy(store->prev_x, store->x, sizeof(float) * count);
+    memcpy(store->prev_y, store->y, sizeof(float) * count);
+    memcpy(store->prev_rotation, store->rotation, sizeof(float) * count);
+}
+
+// Move every entity, and its previous state with it, by (dx, dy). For when the
+// coordinate origin moves rather than the entities.
+void entity_store_translate(EntityStore *store, float dx, float dy)
+{
+    for (int i = 0; i < store->count; i++)
+    {
+        store->x[i] += dx;
+        store->y[i] += dy;
+        store->prev_x[i] += dx;
+        store->prev_y[i] += dy;
+    }
+}
@@ -0,0 +1,153 @@
+#include "flow_field.h"
+#include "engine.h"
+#include <stdio.h>
+#include <string.h>
+
+// Neighbour offsets; a tile's direction is the index of the step towards the target
+static const int flow_steps[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {1, -1}, {-1, 1}};
+
+FlowField *flow_field_create(const Map *map, int radius)
+{
+    FlowField *field = (FlowField *)calloc(1, sizeof(FlowField));
+    if (!field)
+        return NULL;
+
+    field->map = map;
+    field->radius = radius;
+    field->size = radius * 2 + 1;
+    field->cost = malloc(sizeof(uint32_t) * field->size * field->size);
+    field->direction = malloc(field->size * field->size);
+    if (!field->cost || !field->direction)
+    {
+        printf("Unable to allocate flow field!\n");
+        flow_field_destroy(field);
+        return NULL;
+    }
+    return field;
+}
+
+void flow_field_destroy(FlowField *field)
+{
+    if (!field)
+        return;
+    free(field->cost);
+    free(field->direction);
+    free(field->open.entries);
+    free(field);
+}
+
+static int open_tile(const FlowField *field, int x, int y)
+{
+    const Map *map = field->map;
+    return x >= field->origin_x && y >= field->origin_y && x < field->origin_x + field->size &&
+           y < field->origin_y + field->size && x >= 0 && y >= 0 && x < map->width && y < map->height &&
+           map_is_walkable(map, x, y);
+}
+
+// Dijkstra outward from the target. Every tile is relaxed from a neighbour nearer the
+// target, so the step back to that neighbour is its best move.
+static void compute(FlowField *field)
+{
+    int cells = field->size * field->size;
+    for (int i = 0; i < cells; i++)
+    {
+        field->cost[i] = PATH_UNREACHABLE;
+        field->direction[i] = FLOW_UNREACHED;
+    }
+    field->open.count = 0;
+    field->valid = 1;
+    if (!open_tile(field, field->target_x, field->target_y))
+        return;
+
+    int start = field->radius * field->size + field->radius;
+    field->cost[start] = 0;
+    field->direction[start] = FLOW_AT_TARGET;
+    path_heap_push(&field->open, 0, start);
+
+    while (field->open.count > 0)
+    {
+        uint32_t f = field->open.entries[0].f;
+        int local = path_heap_pop(&field->open);
+        if (f != field->cost[local])
+            continue; // stale duplicate
+
+        int x = field->origin_x + local % field->size;
+        int y = field->origin_y + local / field->size;
+        for (int s = 0; s < 8; s++)
+        {
+            int dx = flow_steps[s][0];
+            int dy = flow_steps[s][1];
+            if (!open_tile(field, x + dx, y + dy))
+                continue;
+            // Same no corner cutting rule as the pathfinder
+            if (dx != 0 && dy != 0 && (!open_tile(field, x + dx, y) || !open_tile(field, x, y + dy)))
+                continue;
+
+            int next = local + dy * field->size + dx;
+            uint32_t cost = f + (dx != 0 && dy != 0 ? PATH_COST_DIAGONAL : PATH_COST_STRAIGHT);
+            if (cost < field->cost[next])
+            {
+                field->cost[next] = cost;
+                field->direction[next] = (int8_t)(s ^ 1); // steps come in opposite pairs
+                path_heap_push(&field->open, cost, next);
+            }
+        }
+    }
+}
+
+// Point the field at a target tile. Recomputes only if the target moved to another
+// tile or the window was invalidated; returns 1 when it did.
+int flow_field_update(FlowField *field, int target_x, int target_y)
+{
+    if (field->valid && field->target_x == target_x && field->target_y == target_y)
+        return 0;
+
+    field->target_x = target_x;
+    field->target_y = target_y;
+    field->origin_x = target_x - field->radius;
+    field->origin_y = target_y - field->radius;
+    compute(field);
+    return 1;
+}
+
+// Call after changing a tile's walkability; only tiles inside the window matter
+void flow_field_invalidate_tile(FlowField *field, int x, int y)
+{
+    if (x >= field->origin_x && y >= field->origin_y && x < field->origin_x + field->size &&
+        y < field->origin_y + field->size)
+    {
+        field->valid = 0;
+    }
+}
+
+// Call after changing many tiles at once; the next update recomputes regardless
+void flow_field_invalidate_all(FlowField *field)
+{
+    field->valid = 0;
+}
+
+// Centre of the tile to head for from pixel position (x, y): the next tile towards the
+// target, or the target tile itself once there. Returns 0 outside the window or where
+// the target can't be reached.
+int flow_field_sample(const FlowField *field, float x, float y, float *next_x, float *next_y)
+{
+    if (!field->valid || x < 0.0f || y < 0.0f)
+        return 0;
+
+    int tile_x = (int)(x / TILE_SIZE) - field->origin_x;
+    int tile_y = (int)(y / TILE_SIZE) - field->origin_y;
+    if (tile_x < 0 || tile_y < 0 || tile_x >= field->size || tile_y >= field->size)
+        return 0;
+
+    int direction = field->direction[tile_y * field->size + tile_x];
+    if (direction == FLOW_UNREACHED)
+        return 0;
+    if (direction != FLOW_AT_TARGET)
+    {
+        tile_x += flow_steps[direction][0];
+        tile_y += flow_steps[direction][1];
+    }
+    *next_x = (field->origin_x + tile_x) * TILE_SIZE + TILE_SIZE / 2;
+    *next_y = (field->origin_y + tile_y) * TILE_SIZE + TILE_SIZE / 2;
+    return 1;
+}
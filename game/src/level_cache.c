@@ -0,0 +1,287 @@
+#include "level_cache.h"
+#include "mapgen.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint32_t fnv1a(uint32_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Only the fields generate_map reads go into the key
+uint32_t level_config_hash(const LevelConfig *config)
+{
+    uint32_t hash = 2166136261u;
+    hash = fnv1a(hash, &config->seed, sizeof(config->seed));
+    hash = fnv1a(hash, &config->width, sizeof(config->width));
+    hash = fnv1a(hash, &config->height, sizeof(config->height));
+    return hash;
+}
+
+static void cache_path(const LevelConfig *config, char *path, size_t size)
+{
+    snprintf(path, size, LEVEL_CACHE_DIR "/level_%08x.bin", level_config_hash(config));
+}
+
+static const uint8_t *map_file(const char *path, size_t *size)
+{
+#ifdef _WIN32
+    // No mmap here, read the file in one go instead
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = length > 0 ? malloc(length) : NULL;
+    if (!data || fread(data, 1, length, file) != (size_t)length)
+    {
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *size = length;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    *size = st.st_size;
+    return data;
+#endif
+}
+
+static void unmap_file(const uint8_t *data, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    free((void *)data);
+#else
+    munmap((void *)data, size);
+#endif
+}
+
+// The file keeps cells row-major whatever the in-memory layout is
+static uint32_t map_checksum(const Map *map)
+{
+    uint32_t hash = 2166136261u;
+    for (int y = 0; y < map->height; y++)
+    {
+        for (int x = 0; x < map->width; x++)
+            hash = fnv1a(hash, get_cell(map, x, y), sizeof(Cell));
+    }
+    return hash;
+}
+
+static int decode_cells(const LevelCacheHeader *header, const uint8_t *payload, Map *map)
+{
+    size_t cell_count = (size_t)map->width * map->height;
+
+    if (header->encoding == LEVEL_CACHE_RAW)
+    {
+        if (header->payload_size != cell_count * sizeof(Cell))
+            return -1;
+        const Cell *cells = (const Cell *)payload;
+        for (size_t i = 0; i < cell_count; i++)
+            set_cell(map, i % map->width, i / map->width, cells[i].flags, cells[i].tile_type);
+        return 0;
+    }
+
+    if (header->encoding != LEVEL_CACHE_RLE || header->payload_size % sizeof(LevelCacheRun) != 0)
+        return -1;
+
+    const LevelCacheRun *runs = (const LevelCacheRun *)payload;
+    size_t run_count = header->payload_size / sizeof(LevelCacheRun);
+    size_t filled = 0;
+    for (size_t i = 0; i < run_count; i++)
+    {
+        if (runs[i].count == 0 || runs[i].count > cell_count - filled)
+            return -1;
+        for (int j = 0; j < runs[i].count; j++, filled++)
+            set_cell(map, filled % map->width, filled / map->width, runs[i].cell.flags, runs[i].cell.tile_type);
+    }
+    return filled == cell_count ? 0 : -1;
+}
+
+// Returns NULL on a miss, a stale entry (other generator or config) or a corrupt file
+Map *level_cache_load(const LevelConfig *config)
+{
+    char path[256];
+    cache_path(config, path, sizeof(path));
+
+    size_t size = 0;
+    const uint8_t *data = map_file(path, &size);
+    if (!data)
+        return NULL;
+
+    const LevelCacheHeader *header = (const LevelCacheHeader *)data;
+    if (size < sizeof(LevelCacheHeader) || header->magic != LEVEL_CACHE_MAGIC ||
+        header->format != LEVEL_CACHE_FORMAT || header->generator_version != MAPGEN_VERSION ||
+        header->config_hash != level_config_hash(config) || header->seed != config->seed ||
+        header->width != config->width || header->height != config->height ||
+        header->payload_size > size - sizeof(LevelCacheHeader))
+    {
+        unmap_file(data, size);
+        return NULL;
+    }
+
+    Map *map = create_map(config->width, config->height);
+    if (!map)
+    {
+        unmap_file(data, size);
+        return NULL;
+    }
+    if (decode_cells(header, data + sizeof(LevelCacheHeader), map) != 0 || map_checksum(map) != header->checksum)
+    {
+        printf("Level cache %s is corrupt, regenerating\n", path);
+        cleanup_map(map);
+        map = NULL;
+    }
+
+    unmap_file(data, size);
+    return map;
+}
+
+// Copy the cells out row-major and run-length encode them; returns the run count
+static size_t encode_cells(const Map *map, Cell *raw, LevelCacheRun *runs)
+{
+    size_t cell_count = (size_t)map->width * map->height;
+    for (size_t i = 0; i < cell_count; i++)
+        raw[i] = *get_cell(map, i % map->width, i / map->width);
+
+    size_t run_count = 0;
+    for (size_t i = 0; i < cell_count;)
+    {
+        Cell cell = raw[i];
+        size_t length = 1;
+        while (i + length < cell_count && length < UINT16_MAX &&
+               raw[i + length].flags == cell.flags &&
+               raw[i + length].tile_type == cell.tile_type)
+        {
+            length++;
+        }
+        runs[run_count].count = (uint16_t)length;
+        runs[run_count].cell = cell;
+        run_count++;
+        i += length;
+    }
+    return run_count;
+}
+
+int level_cache_save(const LevelConfig *config, const Map *map)
+{
+#ifdef _WIN32
+    _mkdir(LEVEL_CACHE_DIR);
+#else
+    mkdir(LEVEL_CACHE_DIR, 0755);
+#endif
+
+    size_t cell_count = (size_t)map->width * map->height;
+    Cell *raw = malloc(sizeof(Cell) * cell_count);
+    LevelCacheRun *runs = malloc(sizeof(LevelCacheRun) * cell_count);
+    if (!raw || !runs)
+    {
+        free(raw);
+        free(runs);
+        return -1;
+    }
+
+    size_t raw_size = cell_count * sizeof(Cell);
+    size_t run_count = encode_cells(map, raw, runs);
+
+    LevelCacheHeader header = {0};
+    header.magic = LEVEL_CACHE_MAGIC;
+    header.format = LEVEL_CACHE_FORMAT;
+    header.generator_version = MAPGEN_VERSION;
+    header.config_hash = level_config_hash(config);
+    header.seed = config->seed;
+    header.width = map->width;
+    header.height = map->height;
+    header.checksum = fnv1a(2166136261u, raw, raw_size);
+
+    const void *payload;
+    if (run_count * sizeof(LevelCacheRun) < raw_size)
+    {
+        header.encoding = LEVEL_CACHE_RLE;
+        header.payload_size = run_count * sizeof(LevelCacheRun);
+        payload = runs;
+    }
+    else
+    {
+        header.encoding = LEVEL_CACHE_RAW;
+        header.payload_size = raw_size;
+        payload = raw;
+    }
+
+    // Write beside the final name and rename, so a crash never leaves a half-written entry
+    char path[256], temp_path[264];
+    cache_path(config, path, sizeof(path));
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    FILE *file = fopen(temp_path, "wb");
+    if (!file)
+    {
+        free(raw);
+        free(runs);
+        return -1;
+    }
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(payload, 1, header.payload_size, file) == header.payload_size;
+    ok = (fclose(file) == 0) && ok;
+    free(raw);
+    free(runs);
+
+#ifdef _WIN32
+    remove(path);
+#endif
+    if (!ok || rename(temp_path, path) != 0)
+    {
+        printf("Unable to write level cache %s\n", path);
+        remove(temp_path);
+        return -1;
+    }
+    return 0;
+}
+
+Map *level_cache_load_or_generate(const LevelConfig *config)
+{
+    Map *map = level_cache_load(config);
+    if (map)
+        return map;
+
+    map = create_map(config->width, config->height);
+    if (!map)
+        return NULL;
+    generate_map(map, config->seed);
+    level_cache_save(config, map);
+    return map;
+}
@@ -0,0 +1,140 @@
+#include "level_manager.h"
+#include "level_cache.h"
+#include "enemy.h"
+#include "engine.h"
+#include <string.h>
+
+static void free_level_data(LevelData *level)
+{
+    collision_field_destroy(level->collision);
+    pathfinder_destroy(level->pathfinder);
+    flow_field_destroy(level->chase_field);
+    free(level->enemy_x);
+    free(level->enemy_y);
+    cleanup_map(level->map);
+    memset(level, 0, sizeof(LevelData));
+}
+
+// Load or generate the map and build everything derived from it. Safe to run off the
+// main thread: nothing here touches the renderer or shared game state.
+static int build_level_data(LevelData *level, const LevelConfig *config, int enemy_count)
+{
+    memset(level, 0, sizeof(LevelData));
+    level->map = level_cache_load_or_generate(config);
+    if (!level->map)
+        return -1;
+
+    level->collision = collision_field_create(level->map);
+    level->pathfinder = pathfinder_create(level->map);
+    level->chase_field = flow_field_create(level->map, FLOW_FIELD_RADIUS);
+    level->enemy_x = malloc(sizeof(float) * (enemy_count > 0 ? enemy_count : 1));
+    level->enemy_y = malloc(sizeof(float) * (enemy_count > 0 ? enemy_count : 1));
+    if (!level->collision || !level->pathfinder || !level->chase_field || !level->enemy_x || !level->enemy_y)
+    {
+        printf("Unable to allocate level data!\n");
+        free_level_data(level);
+        return -1;
+    }
+
+    level->spawn_x = (level->map->width * TILE_SIZE) / 2;
+    level->spawn_y = (level->map->height * TILE_SIZE) / 2;
+    level->enemy_count = enemy_pick_spawns(level->collision, config->seed, enemy_count, level->spawn_x,
+                                           level->spawn_y, ENEMY_SPAWN_CLEARANCE, level->enemy_x, level->enemy_y);
+    return 0;
+}
+
+static int pregenerate_main(void *data)
+{
+    LevelManager *manager = (LevelManager *)data;
+    manager->next_failed = build_level_data(&manager->next, &manager->next_config, manager->enemy_count) != 0;
+    SDL_AtomicSet(&manager->next_ready, 1);
+    return 0;
+}
+
+static void start_pregeneration(LevelManager *manager)
+{
+    manager->next_level_number = manager->level_number + 1;
+    manager->next_config = load_level_config(manager->next_level_number);
+    memset(&manager->next, 0, sizeof(LevelData));
+    manager->next_failed = 0;
+    SDL_AtomicSet(&manager->next_ready, 0);
+
+    manager->next_thread = SDL_CreateThread(pregenerate_main, "level_pregen", manager);
+    if (!manager->next_thread)
+    {
+        printf("Unable to start level pre-generation thread! SDL Error: %s\n", SDL_GetError());
+    }
+}
+
+// Collect the finished next level into *level; blocks only if told to wait.
+// Returns -1 if it isn't ready or couldn't be built.
+static int take_next_level(LevelManager *manager, int wait, LevelData *level)
+{
+    if (!manager->next_thread)
+    {
+        // Generator thread never started, fall back to generating in place
+        if (!wait)
+            return -1;
+        return build_level_data(level, &manager->next_config, manager->enemy_count);
+    }
+
+    if (!wait && !SDL_AtomicGet(&manager->next_ready))
+        return -1;
+
+    SDL_WaitThread(manager->next_thread, NULL);
+    manager->next_thread = NULL;
+    *level = manager->next;
+    memset(&manager->next, 0, sizeof(LevelData));
+    return manager->next_failed ? -1 : 0;
+}
+
+int level_manager_init(LevelManager *manager, int first_level, int enemy_count)
+{
+    memset(manager, 0, sizeof(LevelManager));
+    manager->level_number = first_level;
+    manager->enemy_count = enemy_count;
+    manager->config = load_level_config(first_level);
+    if (build_level_data(&manager->current, &manager->config, enemy_count) != 0)
+        return -1;
+
+    start_pregeneration(manager);
+    return 0;
+}
+
+// Swap in the next level once the player stands on an exit door and it has finished
+// generating. Returns 1 when the current level changed; the previous LevelData is
+// freed, so callers must drop any pointers into it.
+int level_manager_try_advance(LevelManager *manager, float player_x, float player_y)
+{
+    const Map *map = manager->current.map;
+    int tile_x = (int)(player_x / TILE_SIZE);
+    int tile_y = (int)(player_y / TILE_SIZE);
+    if (tile_x < 0 || tile_x >= map->width || tile_y < 0 || tile_y >= map->height)
+        return 0;
+    if (get_cell(map, tile_x, tile_y)->tile_type != TILE_DOOR)
+        return 0;
+
+    // Not done yet (huge map, fast player): stay on the door and try again next step
+    LevelData next;
+    if (take_next_level(manager, !manager->next_thread, &next) != 0)
+        return 0;
+
+    free_level_data(&manager->current);
+    manager->current = next;
+    manager->config = manager->next_config;
+    manager->level_number = manager->next_level_number;
+
+    start_pregeneration(manager);
+    return 1;
+}
+
+void level_manager_shutdown(LevelManager *manager)
+{
+    if (manager->next_thread)
+    {
+        LevelData next;
+        take_next_level(manager, 1, &next);
+        free_level_data(&next);
+    }
+    free_level_data(&manager->current);
+}
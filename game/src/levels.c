@@ -1,95 +1,40 @@
 #include "levels.h"
 #include <time.h>
 #include "engine.h"
+#include "mapgen.h"
+#include "rng.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 void connect_floor_areas(Map *map, int start_x, int start_y);
-void flood_fill(Map *map, int *visited, int x, int y, int mark);
-void create_path_to_main_area(Map *map, int *visited, int start_x, int start_y);
+int label_floor_regions(Map *map, int *labels, int **region_starts);
+void carve_path_to_main_area(Map *map, int *labels, int *parent, int region, int main_region, int start_index);
 void add_decorative_features(Map *map, uint32_t seed);
+void place_exit_door(Map *map, int start_x, int start_y);
 
 // Cellular automata map generation with guaranteed connectivity
 void generate_map(Map *map, uint32_t seed)
 {
-    srand(seed);
-    
-    // Initialize with random noise (35% walls)
-    for (int y = 0; y < map->height; y++)
+    // Wall state lives in a bitboard during generation and is expanded to cells at the end
+    WallBitboard walls, scratch;
+    if (bitboard_init(&walls, map->width, map->height) != 0 ||
+        bitboard_init(&scratch, map->width, map->height) != 0)
     {
-        for (int x = 0; x < map->width; x++)
-        {
-            Cell *cell = get_cell(map, x, y);
-            
-            // Force border to be walls
-            if (x == 0 || x == map->width - 1 || y == 0 || y == map->height - 1)
-            {
-                cell->flags = 0;
-                cell->tile_type = TILE_WALL;
-            }
-            else
-            {
-                // 35% chance of wall in interior
-                if (rand() % 100 < 35)
-                {
-                    cell->flags = 0;
-                    cell->tile_type = TILE_WALL;
-                }
-                else
-                {
-                    cell->flags = WALKABLE;
-                    cell->tile_type = TILE_FLOOR;
-                }
-            }
-        }
+        printf("Unable to allocate map generation buffers!\n");
+        bitboard_free(&walls);
+        return;
     }
 
+    // Initialize with random noise (35% walls)
+    bitboard_fill_noise(&walls, seed, 35);
+
     // Cellular automata smoothing (3 iterations)
-    for (int iteration = 0; iteration < 3; iteration++)
-    {
-        // Create temporary map for new state
-        Cell *temp_cells = malloc(sizeof(Cell) * map->width * map->height);
-        memcpy(temp_cells, map->cells, sizeof(Cell) * map->width * map->height);
-        
-        for (int y = 1; y < map->height - 1; y++)
-        {
-            for (int x = 1; x < map->width - 1; x++)
-            {
-                int wall_count = 0;
-                
-                // Count walls in 3x3 neighborhood
-                for (int dy = -1; dy <= 1; dy++)
-                {
-                    for (int dx = -1; dx <= 1; dx++)
-                    {
-                        Cell *neighbor = get_cell(map, x + dx, y + dy);
-                        if (neighbor->tile_type == TILE_WALL)
-                            wall_count++;
-                    }
-                }
-                
-                Cell *temp_cell = &temp_cells[y * map->width + x];
-                
-                // Apply cellular automata rule
-                if (wall_count >= 5)
-                {
-                    temp_cell->flags = 0;
-                    temp_cell->tile_type = TILE_WALL;
-                }
-                else
-                {
-                    temp_cell->flags = WALKABLE;
-                    temp_cell->tile_type = TILE_FLOOR;
-                }
-            }
-        }
-        
-        // Copy temp back to main map
-        memcpy(map->cells, temp_cells, sizeof(Cell) * map->width * map->height);
-        free(temp_cells);
-    }
+    bitboard_smooth(&walls, &scratch, 3);
+    bitboard_to_cells(&walls, map);
+    bitboard_free(&walls);
+    bitboard_free(&scratch);
 
     // Spawn area is clear (center of map)
     int center_x = map->width / 2;
@@ -105,9 +50,7 @@ void generate_map(Map *map, uint32_t seed)
             
             if (px >= 0 && px < map->width && py >= 0 && py < map->height)
             {
-                Cell *cell = get_cell(map, px, py);
-                cell->flags = WALKABLE;
-                cell->tile_type = TILE_FLOOR;
+                set_cell(map, px, py, WALKABLE, TILE_FLOOR);
             }
         }
     }
@@ -115,99 +58,261 @@ void generate_map(Map *map, uint32_t seed)
     // Connect isolated floor areas using flood fill
     connect_floor_areas(map, center_x, center_y);
 
+    // Exit to the next level as far from the spawn as the caves allow
+    place_exit_door(map, center_x, center_y);
+
     // add_decorative_features(map, seed);
 }
 
+static int find_region(int *parent, int region)
+{
+    // Union-find root with path halving
+    while (parent[region] != region)
+    {
+        parent[region] = parent[parent[region]];
+        region = parent[region];
+    }
+    return region;
+}
+
 void connect_floor_areas(Map *map, int start_x, int start_y)
 {
-    // Create visited array
-    int *visited = calloc(map->width * map->height, sizeof(int));
-    
-    // Flood fill from spawn point to mark main area
-    flood_fill(map, visited, start_x, start_y, 1);
-    
-    // Find unconnected floor tiles and create paths to them
-    for (int y = 1; y < map->height - 1; y++)
+    int size = map->width * map->height;
+    int *labels = malloc(sizeof(int) * size);
+    int *region_starts = NULL;
+    if (!labels)
+    {
+        printf("Unable to allocate region labels, skipping connectivity pass!\n");
+        return;
+    }
+
+    int region_count = label_floor_regions(map, labels, &region_starts);
+    if (region_count < 0)
+    {
+        printf("Unable to allocate region buffers, skipping connectivity pass!\n");
+        free(labels);
+        return;
+    }
+    int main_region = labels[start_y * map->width + start_x];
+    if (region_count <= 1 || main_region < 0)
+    {
+        free(labels);
+        free(region_starts);
+        return;
+    }
+
+    // Regions joined by a carved path share a root, so each region is connected at most once
+    int *parent = malloc(sizeof(int) * region_count);
+    if (!parent)
+    {
+        printf("Unable to allocate region links, skipping connectivity pass!\n");
+        free(region_starts);
+        free(labels);
+        return;
+    }
+    for (int region = 0; region < region_count; region++)
+    {
+        parent[region] = region;
+    }
+
+    for (int region = 0; region < region_count; region++)
+    {
+        if (find_region(parent, region) != find_region(parent, main_region))
+        {
+            carve_path_to_main_area(map, labels, parent, region, main_region, region_starts[region]);
+        }
+    }
+
+    free(parent);
+    free(region_starts);
+    free(labels);
+}
+
+// Label 4-connected floor regions in scan order using an explicit queue instead of recursion.
+// Non-floor cells get -1. region_starts receives the first cell (in scan order) of each region.
+// Returns the region count, or -1 if the buffers couldn't be allocated.
+int label_floor_regions(Map *map, int *labels, int **region_starts)
+{
+    int size = map->width * map->height;
+    int *queue = malloc(sizeof(int) * size);
+    int starts_capacity = 64;
+    int *starts = malloc(sizeof(int) * starts_capacity);
+    int region_count = 0;
+    *region_starts = NULL;
+    if (!queue || !starts)
+    {
+        free(queue);
+        free(starts);
+        return -1;
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+        labels[i] = -1;
+    }
+
+    for (int y = 0; y < map->height; y++)
     {
-        for (int x = 1; x < map->width - 1; x++)
+        for (int x = 0; x < map->width; x++)
         {
-            Cell *cell = get_cell(map, x, y);
             int index = y * map->width + x;
-            
-            // If floor tile but not connected to main area
-            if (cell->tile_type == TILE_FLOOR && !visited[index])
+            if (labels[index] >= 0 || get_cell(map, x, y)->tile_type != TILE_FLOOR)
+                continue;
+
+            if (region_count >= starts_capacity)
             {
-                // Create a path from isolated area to the main area
-                create_path_to_main_area(map, visited, x, y);
+                int *grown = realloc(starts, sizeof(int) * starts_capacity * 2);
+                if (!grown)
+                {
+                    free(queue);
+                    free(starts);
+                    return -1;
+                }
+                starts = grown;
+                starts_capacity *= 2;
+            }
+            starts[region_count] = index;
+
+            // Breadth-first fill; every cell enters the queue at most once
+            int head = 0, tail = 0;
+            queue[tail++] = index;
+            labels[index] = region_count;
+            while (head < tail)
+            {
+                int current = queue[head++];
+                int cx = current % map->width;
+                int cy = current / map->width;
+
+                int neighbors[4][2] = {{cx + 1, cy}, {cx - 1, cy}, {cx, cy + 1}, {cx, cy - 1}};
+                for (int n = 0; n < 4; n++)
+                {
+                    int nx = neighbors[n][0];
+                    int ny = neighbors[n][1];
+                    if (nx < 0 || nx >= map->width || ny < 0 || ny >= map->height)
+                        continue;
+
+                    int neighbor_index = ny * map->width + nx;
+                    if (labels[neighbor_index] >= 0 || get_cell(map, nx, ny)->tile_type != TILE_FLOOR)
+                        continue;
+
+                    labels[neighbor_index] = region_count;
+                    queue[tail++] = neighbor_index;
+                }
             }
+
+            region_count++;
         }
     }
-    
-    free(visited);
-}
 
-void flood_fill(Map *map, int *visited, int x, int y, int mark)
-{
-    if (x < 0 || x >= map->width || y < 0 || y >= map->height)
-        return;
-    
-    int index = y * map->width + x;
-    if (visited[index])
-        return;
-    
-    Cell *cell = get_cell(map, x, y);
-    if (cell->tile_type != TILE_FLOOR)
-        return;
-    
-    visited[index] = mark;
-    
-    // Recursively fill adjacent cells
-    flood_fill(map, visited, x + 1, y, mark);
-    flood_fill(map, visited, x - 1, y, mark);
-    flood_fill(map, visited, x, y + 1, mark);
-    flood_fill(map, visited, x, y - 1, mark);
+    free(queue);
+    *region_starts = starts;
+    return region_count;
 }
 
-void create_path_to_main_area(Map *map, int *visited, int start_x, int start_y)
+void carve_path_to_main_area(Map *map, int *labels, int *parent, int region, int main_region, int start_index)
 {
     // Simple pathfinding: move towards center while clearing walls
     int target_x = map->width / 2;
     int target_y = map->height / 2;
-    
-    int current_x = start_x;
-    int current_y = start_y;
-    
-    // Create path towards center
+
+    int current_x = start_index % map->width;
+    int current_y = start_index / map->width;
+
     while (current_x != target_x || current_y != target_y)
     {
-        // Move towards target
-        if (current_x < target_x) current_x++;
-        else if (current_x > target_x) current_x--;
-        
-        if (current_y < target_y) current_y++;
-        else if (current_y > target_y) current_y--;
-        
-        // Clear this cell and mark as connected
-        Cell *cell = get_cell(map, current_x, current_y);
-        cell->flags = WALKABLE;
-        cell->tile_type = TILE_FLOOR;
-        visited[current_y * map->width + current_x] = 1;
-        
-        // If reached the main area, stop
-        if (visited[current_y * map->width + current_x])
-            break;
+        // Step along one axis at a time so the carved path stays 4-connected
+        int dx = target_x - current_x;
+        int dy = target_y - current_y;
+        if (abs(dx) >= abs(dy))
+            current_x += dx > 0 ? 1 : -1;
+        else
+            current_y += dy > 0 ? 1 : -1;
+
+        int index = current_y * map->width + current_x;
+        int other = labels[index];
+
+        if (other < 0)
+        {
+            // Clear this cell; it now belongs to the region being connected
+            set_cell(map, current_x, current_y, WALKABLE, TILE_FLOOR);
+            labels[index] = region;
+            continue;
+        }
+
+        int other_root = find_region(parent, other);
+        int region_root = find_region(parent, region);
+        if (other_root == find_region(parent, main_region))
+        {
+            // Reached the main area (directly or through an earlier path)
+            parent[region_root] = other_root;
+            return;
+        }
+
+        // Crossed another isolated region, which is now joined to this one
+        if (other_root != region_root)
+            parent[other_root] = region_root;
     }
 }
 
+void place_exit_door(Map *map, int start_x, int start_y)
+{
+    int size = map->width * map->height;
+    int *queue = malloc(sizeof(int) * size);
+    uint8_t *visited = calloc(size, 1);
+    if (!queue || !visited)
+    {
+        printf("Unable to allocate door search buffers, level has no exit!\n");
+        free(queue);
+        free(visited);
+        return;
+    }
+
+    // Breadth-first walk from the spawn; the last tile dequeued is the farthest one
+    int head = 0, tail = 0;
+    int start = start_y * map->width + start_x;
+    queue[tail++] = start;
+    visited[start] = 1;
+    int farthest = start;
+
+    while (head < tail)
+    {
+        int index = queue[head++];
+        farthest = index;
+        int x = index % map->width;
+        int y = index / map->width;
+
+        const int dx[4] = {1, -1, 0, 0};
+        const int dy[4] = {0, 0, 1, -1};
+        for (int i = 0; i < 4; i++)
+        {
+            int nx = x + dx[i];
+            int ny = y + dy[i];
+            if (nx < 0 || nx >= map->width || ny < 0 || ny >= map->height)
+                continue;
+            int next = ny * map->width + nx;
+            if (visited[next] || !map_is_walkable(map, nx, ny))
+                continue;
+            visited[next] = 1;
+            queue[tail++] = next;
+        }
+    }
+
+    if (farthest != start)
+    {
+        set_cell(map, farthest % map->width, farthest / map->width, WALKABLE | DOOR, TILE_DOOR);
+    }
+
+    free(queue);
+    free(visited);
+}
+
 void add_decorative_features(Map *map, uint32_t seed)
 {
-    srand(seed + 12345); // Different seed for decorations
-    
     // Add some water patches in open areas
     for (int attempts = 0; attempts < map->width * map->height / 50; attempts++)
     {
-        int x = 2 + rand() % (map->width - 4);
-        int y = 2 + rand() % (map->height - 4);
+        int x = 2 + rng_range(rng_u32(seed, RNG_STREAM_MAP_DECOR, attempts, 0), map->width - 4);
+        int y = 2 + rng_range(rng_u32(seed, RNG_STREAM_MAP_DECOR, attempts, 1), map->height - 4);
         
         // Check if area is clear (3x3)
         int clear = 1;
@@ -215,7 +320,7 @@ void add_decorative_features(Map *map, uint32_t seed)
         {
             for (int dx = -1; dx <= 1 && clear; dx++)
             {
-                Cell *cell = get_cell(map, x + dx, y + dy);
+                const Cell *cell = get_cell(map, x + dx, y + dy);
                 if (cell->tile_type != TILE_FLOOR)
                     clear = 0;
             }
@@ -228,9 +333,7 @@ void add_decorative_features(Map *map, uint32_t seed)
         
         if (clear && dist_to_center > 10)
         {
-            Cell *cell = get_cell(map, x, y);
-            cell->flags = 0; // Water is not walkable
-            cell->tile_type = TILE_WATER;
+            set_cell(map, x, y, 0, TILE_WATER); // Water is not walkable
         }
     }
 }
@@ -238,9 +341,23 @@ void add_decorative_features(Map *map, uint32_t seed)
 Map *create_map(int width, int height)
 {
     Map *map = (Map *)malloc(sizeof(Map));
+    if (!map)
+        return NULL;
     map->width = width;
     map->height = height;
-    map->cells = (Cell *)malloc(sizeof(Cell) * width * height);
+    map->blocks_w = (width + MAP_BLOCK_MASK) >> MAP_BLOCK_SHIFT;
+    map->walk_words_per_row = (width + 63) / 64;
+
+    // Padding tiles in partial edge blocks stay zeroed (not walkable)
+    int blocks_h = (height + MAP_BLOCK_MASK) >> MAP_BLOCK_SHIFT;
+    map->cells = (Cell *)calloc((size_t)map->blocks_w * blocks_h * MAP_BLOCK_SIZE * MAP_BLOCK_SIZE, sizeof(Cell));
+    map->walkable = (uint64_t *)calloc((size_t)map->walk_words_per_row * height, sizeof(uint64_t));
+    if (!map->cells || !map->walkable)
+    {
+        printf("Unable to allocate %dx%d map!\n", width, height);
+        cleanup_map(map);
+        return NULL;
+    }
     return map;
 }
 
@@ -249,6 +366,7 @@ void cleanup_map(Map *map)
     if (map)
     {
         free(map->cells);
+        free(map->walkable);
         free(map);
     }
 }
@@ -2,84 +2,277 @@
 #include "engine.h"
 #include "player.h"
 #include <stdbool.h>
+#include <string.h>
 #include "levels.h"
+#include "level_manager.h"
+#include "world.h"
 #include "enemy.h"
+#include "tile_cache.h"
+#include "frame_pacer.h"
+#include "job_system.h"
 
-void render_map_with_camera(Map *map, Camera *camera)
+#define DEFAULT_SIM_RATE_HZ 60.0f
+#define MAX_FRAME_TIME 0.25f // longest frame the simulation catches up on
+#define DEFAULT_ENEMY_COUNT 500
+
+// Simulation rate, overridable with ARPG_SIM_HZ for slower machines
+static float get_sim_rate()
+{
+    const char *value = SDL_getenv("ARPG_SIM_HZ");
+    if (value)
+    {
+        float rate = (float)atof(value);
+        if (rate >= 1.0f && rate <= 1000.0f)
+            return rate;
+        printf("Ignoring invalid ARPG_SIM_HZ=%s\n", value);
+    }
+    return DEFAULT_SIM_RATE_HZ;
+}
+
+// ARPG_DETERMINISTIC=1 runs all jobs inline in submission order, for reproducible runs
+static void init_job_mode()
+{
+    const char *value = SDL_getenv("ARPG_DETERMINISTIC");
+    if (value && atoi(value) != 0)
+    {
+        job_system_set_deterministic(1);
+        printf("Deterministic job mode: running all jobs on the submitting thread\n");
+    }
+}
+
+// Enemies per level, overridable with ARPG_ENEMY_COUNT for stress testing
+static int get_enemy_count()
+{
+    const char *value = SDL_getenv("ARPG_ENEMY_COUNT");
+    if (value)
+    {
+        int count = atoi(value);
+        if (count >= 0)
+            return count;
+        printf("Ignoring invalid ARPG_ENEMY_COUNT=%s\n", value);
+    }
+    return DEFAULT_ENEMY_COUNT;
+}
+
+// ARPG_WORLD_SEED=<seed> plays the endless chunked world instead of the levels.
+// Returns 1 and sets *seed when it is set.
+static int get_world_seed(uint32_t *seed)
 {
-    // Calculate visible tile range based on camera position
-    float camera_left = camera->x - (camera->screen_width / 2.0f);
-    float camera_top = camera->y - (camera->screen_height / 2.0f);
-    float camera_right = camera_left + camera->screen_width;
-    float camera_bottom = camera_top + camera->screen_height;
-
-    const int TILE_MARGIN = 1; // number of extra tiles around the screen
-    int start_x = (int)(camera_left / TILE_SIZE) - TILE_MARGIN;
-    int start_y = (int)(camera_top / TILE_SIZE) - TILE_MARGIN;
-    int end_x = (int)(camera_right / TILE_SIZE) + TILE_MARGIN;
-    int end_y = (int)(camera_bottom / TILE_SIZE) + TILE_MARGIN;
-
-    // Clamp to map bounds
-    if (start_x < 0)
-        start_x = 0;
-    if (start_y < 0)
-        start_y = 0;
-    if (end_x >= map->width)
-        end_x = map->width - 1;
-    if (end_y >= map->height)
-        end_y = map->height - 1;
-
-    // Render visible tiles
-    for (int y = start_y; y <= end_y; y++)
-    {
-        for (int x = start_x; x <= end_x; x++)
+    const char *value = SDL_getenv("ARPG_WORLD_SEED");
+    if (value)
+    {
+        char *end;
+        unsigned long parsed = strtoul(value, &end, 10);
+        if (end != value && *end == '\0')
         {
-            Cell *cell = get_cell(map, x, y);
-
-            // Convert world position to screen position
-            float world_x = x * TILE_SIZE + (TILE_SIZE / 2); // Center of tile
-            float world_y = y * TILE_SIZE + (TILE_SIZE / 2);
-            float screen_x, screen_y;
-            camera_world_to_screen(camera, world_x, world_y, &screen_x, &screen_y);
-
-            RenderCommand tile_cmd = {
-                screen_x, screen_y,
-                0.0f,            // rotation
-                1.0f,            // scale
-                cell->tile_type, // sprite_id
-                0                // layer (background)
-            };
-
-            engine_submit(tile_cmd);
+            *seed = (uint32_t)parsed;
+            printf("World mode with seed %u\n", *seed);
+            return 1;
         }
+        printf("Ignoring invalid ARPG_WORLD_SEED=%s\n", value);
+    }
+    return 0;
+}
+
+// World mode: the systems see a WorldView's map, and what is derived from it is
+// rebuilt in place whenever chunks are copied in or the view moves
+typedef struct {
+    uint32_t seed;
+    World *world;
+    WorldView view;
+    CollisionField *collision;
+    Pathfinder *pathfinder;
+    FlowField *chase_field;
+    int enemies_placed;
+} WorldMode;
+
+static void world_mode_shutdown(WorldMode *mode)
+{
+    collision_field_destroy(mode->collision);
+    pathfinder_destroy(mode->pathfinder);
+    flow_field_destroy(mode->chase_field);
+    world_view_free(&mode->view);
+    world_destroy(mode->world);
+    memset(mode, 0, sizeof(WorldMode));
+}
+
+static int world_mode_init(WorldMode *mode, uint32_t seed)
+{
+    memset(mode, 0, sizeof(WorldMode));
+    mode->seed = seed;
+    mode->world = world_create(seed);
+    if (!mode->world || world_view_init(&mode->view, 0, 0) != 0)
+    {
+        world_mode_shutdown(mode);
+        return -1;
+    }
+
+    mode->collision = collision_field_create(mode->view.map);
+    mode->pathfinder = pathfinder_create(mode->view.map);
+    mode->chase_field = flow_field_create(mode->view.map, FLOW_FIELD_RADIUS);
+    if (!mode->collision || !mode->pathfinder || !mode->chase_field)
+    {
+        world_mode_shutdown(mode);
+        return -1;
     }
+    return 0;
+}
+
+// Stream the world around the player. When the view moves, everything positioned in
+// view pixels moves with it, so the player stays on the same world tile.
+static void world_mode_update(WorldMode *mode, TileCache *tile_cache, Player *player, EntityStore *enemies,
+                              Camera *camera, int enemy_count)
+{
+    int shift_x, shift_y;
+    int changed = world_view_update(&mode->view, mode->world, player->body.x, player->body.y, &shift_x, &shift_y);
+    if (changed & WORLD_VIEW_MOVED)
+    {
+        float dx = (float)shift_x * TILE_SIZE;
+        float dy = (float)shift_y * TILE_SIZE;
+        player->body.x += dx;
+        player->body.y += dy;
+        body_store_previous(&player->body);
+        entity_store_translate(enemies, dx, dy);
+        camera->x += dx;
+        camera->y += dy;
+    }
+    if (changed)
+    {
+        collision_field_rebuild(mode->collision, mode->view.map);
+        // A graph build over the whole view takes ~100ms, too long to redo each time a
+        // chunk streams in, so world paths stay on the budgeted grid search
+        pathfinder_rebuild(mode->pathfinder, 0);
+        flow_field_invalidate_all(mode->chase_field);
+        tile_cache_invalidate_all(tile_cache);
+    }
+
+    // Enemies are placed once, when the whole first view has been generated
+    if (mode->enemies_placed || mode->view.filled_count < WORLD_VIEW_CHUNKS * WORLD_VIEW_CHUNKS)
+        return;
+    mode->enemies_placed = 1;
+    float *spawn_x = malloc(sizeof(float) * (enemy_count > 0 ? enemy_count : 1));
+    float *spawn_y = malloc(sizeof(float) * (enemy_count > 0 ? enemy_count : 1));
+    if (spawn_x && spawn_y)
+    {
+        int picked = enemy_pick_spawns(mode->collision, mode->seed, enemy_count, player->body.x, player->body.y,
+                                       ENEMY_SPAWN_CLEARANCE, spawn_x, spawn_y);
+        for (int i = 0; i < picked; i++)
+            enemy_spawn(enemies, spawn_x[i], spawn_y[i]);
+    }
+    else
+    {
+        printf("Unable to place world enemies!\n");
+    }
+    free(spawn_x);
+    free(spawn_y);
+}
+
+// Frame pacing from ARPG_FRAME_PACING: "vsync", "uncapped" or a target FPS.
+// Defaults to the display refresh rate.
+static void init_frame_pacing(FramePacer *pacer, SDL_Window *window, SDL_Renderer *renderer)
+{
+    const char *value = SDL_getenv("ARPG_FRAME_PACING");
+    if (value && strcmp(value, "vsync") == 0)
+    {
+        frame_pacer_init(pacer, renderer, FRAME_PACE_VSYNC, 0.0);
+        return;
+    }
+    if (value && strcmp(value, "uncapped") == 0)
+    {
+        frame_pacer_init(pacer, renderer, FRAME_PACE_UNCAPPED, 0.0);
+        return;
+    }
+
+    double target_fps = value ? atof(value) : 0.0;
+    if (target_fps <= 0.0)
+    {
+        SDL_DisplayMode mode;
+        target_fps = 60.0;
+        if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &mode) == 0 && mode.refresh_rate > 0)
+            target_fps = mode.refresh_rate;
+    }
+    frame_pacer_init(pacer, renderer, FRAME_PACE_TARGET_FPS, target_fps);
 }
 
 int main(void)
 {
     SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
     SDL_Window *window = SDL_CreateWindow("ARPG Game", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 1920, 1080, SDL_WINDOW_OPENGL | SDL_WINDOW_BORDERLESS);
-    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
 
     engine_init(renderer);
+    init_job_mode();
+
+    FramePacer pacer;
+    init_frame_pacing(&pacer, window, renderer);
 
     Camera camera;
     camera_init(&camera, 1920, 1080);
     // game_init();
 
-    LevelConfig config = load_level_config(2);
-    Map *map = create_map(config.width, config.height);
-    generate_map(map, config.seed);
+    int enemy_count = get_enemy_count();
+    uint32_t world_seed = 0;
+    int world_mode = get_world_seed(&world_seed);
+    LevelManager levels;
+    WorldMode endless;
+    Map *map;
+    CollisionField *collision;
+    Pathfinder *pathfinder;
+    FlowField *chase_field;
+    float spawn_x, spawn_y;
+    if (world_mode)
+    {
+        if (world_mode_init(&endless, world_seed) != 0)
+        {
+            printf("Unable to create the world!\n");
+            return -1;
+        }
+        map = endless.view.map;
+        collision = endless.collision;
+        pathfinder = endless.pathfinder;
+        chase_field = endless.chase_field;
+        // World tile (0, 0) is always cleared for the spawn
+        spawn_x = -endless.view.origin_x * TILE_SIZE + TILE_SIZE / 2;
+        spawn_y = -endless.view.origin_y * TILE_SIZE + TILE_SIZE / 2;
+    }
+    else
+    {
+        if (level_manager_init(&levels, 2, enemy_count) != 0)
+        {
+            printf("Unable to load the first level!\n");
+            return -1;
+        }
+        // Owned by the level manager and replaced on every level change
+        map = levels.current.map;
+        collision = levels.current.collision;
+        pathfinder = levels.current.pathfinder;
+        chase_field = levels.current.chase_field;
+        spawn_x = levels.current.spawn_x;
+        spawn_y = levels.current.spawn_y;
+    }
+    TileCache *tile_cache = tile_cache_create(map);
+    if (!tile_cache)
+    {
+        printf("Unable to create the tile cache!\n");
+        return -1;
+    }
 
     Player player;
-    int spawn_x = (config.width * TILE_SIZE) / 2;
-    int spawn_y = (config.height * TILE_SIZE) / 2;
     player_init(&player, spawn_x, spawn_y);
 
-    Enemy enemy;
-    enemy_init(&enemy, spawn_x + 100, spawn_y + 100);
+    EntityStore enemies;
+    SpatialHash *enemy_hash = spatial_hash_create(SPATIAL_CELL_SIZE);
+    if (entity_store_init(&enemies) != 0 || !enemy_hash)
+    {
+        printf("Unable to allocate enemy storage!\n");
+        return -1;
+    }
+    for (int i = 0; !world_mode && i < levels.current.enemy_count; i++)
+        enemy_spawn(&enemies, levels.current.enemy_x[i], levels.current.enemy_y[i]);
 
-    const float FIXED_DT = 1.0f / 60.0f;
+    const float FIXED_DT = 1.0f / get_sim_rate();
+    float prev_camera_x = camera.x;
+    float prev_camera_y = camera.y;
     float accumulator = 0.0f;
     uint64_t prev = SDL_GetPerformanceCounter();
 
@@ -89,6 +282,8 @@ int main(void)
         uint64_t now = SDL_GetPerformanceCounter();
         float frameTime = (now - prev) / (float)SDL_GetPerformanceFrequency();
         prev = now;
+        if (frameTime > MAX_FRAME_TIME)
+            frameTime = MAX_FRAME_TIME;
         accumulator += frameTime;
 
         // input
@@ -99,55 +294,99 @@ int main(void)
             {
                 running = false;
             }
+            else if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET)
+            {
+                // Baked chunk contents are lost with the render targets
+                tile_cache_invalidate_all(tile_cache);
+            }
         }
 
         // fixed updates
         while (accumulator >= FIXED_DT)
         {
-            // engine_update(FIXED_DT);
-            // game_update(FIXED_DT);
+            if (world_mode)
+                world_mode_update(&endless, tile_cache, &player, &enemies, &camera, enemy_count);
+
+            body_store_previous(&player.body);
+            entity_store_previous(&enemies);
+            prev_camera_x = camera.x;
+            prev_camera_y = camera.y;
+
+            flow_field_update(chase_field, (int)(player.body.x / TILE_SIZE), (int)(player.body.y / TILE_SIZE));
+            pathfinder_begin_frame(pathfinder, ENEMY_PATH_BUDGET);
+            enemy_system_plan(&enemies, pathfinder, chase_field, enemy_hash, player.body.x, player.body.y);
+            enemy_system_update(&enemies, FIXED_DT, collision, pathfinder, chase_field);
+            enemy_system_separate(&enemies, enemy_hash, collision);
+            player_update(&player, FIXED_DT, &camera, collision);
+            camera_update(&camera, FIXED_DT, map, player.body.x, player.body.y);
             accumulator -= FIXED_DT;
+
+            if (!world_mode && level_manager_try_advance(&levels, player.body.x, player.body.y))
+            {
+                // The new level arrives fully built; only the tile cache, which holds
+                // render targets, is updated here
+                map = levels.current.map;
+                collision = levels.current.collision;
+                pathfinder = levels.current.pathfinder;
+                chase_field = levels.current.chase_field;
+                if (tile_cache_set_map(tile_cache, map) != 0)
+                {
+                    // The old map is already gone, so there is nothing left to draw
+                    printf("Unable to switch the tile cache to the new level!\n");
+                    running = false;
+                    break;
+                }
+
+                player.body.x = levels.current.spawn_x;
+                player.body.y = levels.current.spawn_y;
+                body_store_previous(&player.body);
+                entity_store_clear(&enemies);
+                for (int i = 0; i < levels.current.enemy_count; i++)
+                    enemy_spawn(&enemies, levels.current.enemy_x[i], levels.current.enemy_y[i]);
+
+                // Cut straight to the spawn instead of panning across the new map
+                camera.x = player.body.x;
+                camera.y = player.body.y;
+                camera_update(&camera, 0.0f, map, player.body.x, player.body.y);
+                prev_camera_x = camera.x;
+                prev_camera_y = camera.y;
+            }
         }
+        if (!running)
+            break;
+
+        // Render between the last two simulation steps
+        float alpha = accumulator / FIXED_DT;
+        Camera render_camera = camera;
+        render_camera.x = prev_camera_x + (camera.x - prev_camera_x) * alpha;
+        render_camera.y = prev_camera_y + (camera.y - prev_camera_y) * alpha;
 
         engine_begin_frame();
-        render_map_with_camera(map, &camera);
-
-        enemy_update(&enemy, frameTime, map);
-        player_update(&player, frameTime, &camera, map);
-        camera_update(&camera, frameTime, map, player.body.x, player.body.y);
-
-        float player_screen_x, player_screen_y;
-        camera_world_to_screen(&camera, player.body.x, player.body.y, &player_screen_x, &player_screen_y);
-
-        RenderCommand player_cmd = {
-            player_screen_x,
-            player_screen_y,
-            player.body.rotation,
-            player.body.scale,
-            player.body.sprite_id,
-            1};
-        engine_submit(player_cmd);
-
-        float enemy_screen_x, enemy_screen_y;
-        camera_world_to_screen(&camera, enemy.body.x, enemy.body.y, &enemy_screen_x, &enemy_screen_y);
-
-        RenderCommand enemy_cmd = {
-            enemy_screen_x,
-            enemy_screen_y,
-            enemy.body.rotation,
-            enemy.body.scale,
-            enemy.body.sprite_id,
-            1                  
-        };
-        engine_submit(enemy_cmd);
+        tile_cache_submit(tile_cache, &render_camera, 0);
 
-        engine_end_frame();
+        RenderCommand player_cmd = {0.0f, 0.0f, 0.0f, player.body.scale, player.body.sprite_id, 1};
+        body_interpolate(&player.body, alpha, &player_cmd.x, &player_cmd.y, &player_cmd.rotation);
+        engine_submit_world(&render_camera, &player_cmd, 1);
+        enemy_system_submit(&enemies, &render_camera, alpha, 1);
 
-        SDL_Delay(1); // prevent 100% CPU usage
+        engine_end_frame();
+        frame_pacer_wait(&pacer);
     }
 
+    FrameStats frame_stats;
+    frame_pacer_get_stats(&pacer, &frame_stats);
+    printf("Last %d frames: mean %.2f ms, jitter (stddev) %.2f ms, min %.2f ms, max %.2f ms\n",
+           frame_stats.samples, frame_stats.mean_ms, frame_stats.stddev_ms, frame_stats.min_ms, frame_stats.max_ms);
+
     // game_shutdown();
-    cleanup_map(map);
+    tile_cache_destroy(tile_cache);
+    spatial_hash_destroy(enemy_hash);
+    entity_store_free(&enemies);
+    enemy_system_shutdown();
+    if (world_mode)
+        world_mode_shutdown(&endless);
+    else
+        level_manager_shutdown(&levels);
     engine_shutdown();
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
@@ -0,0 +1,193 @@
+#include "mapgen.h"
+#include "job_system.h"
+#include "rng.h"
+#include <string.h>
+
+// Work split across the job system in horizontal bands of MAPGEN_BAND_ROWS rows
+typedef struct {
+    const WallBitboard *src;
+    WallBitboard *dst;
+    Map *map;
+    uint32_t seed;
+    int wall_percent;
+} BandJob;
+
+static void expand_rows(const WallBitboard *board, Map *map, int row_start, int row_end);
+
+int bitboard_init(WallBitboard *board, int width, int height)
+{
+    board->width = width;
+    board->height = height;
+    board->words_per_row = (width + 63) / 64;
+    board->bits = calloc((size_t)board->words_per_row * height, sizeof(uint64_t));
+    return board->bits ? 0 : -1;
+}
+
+void bitboard_free(WallBitboard *board)
+{
+    free(board->bits);
+    board->bits = NULL;
+}
+
+static void noise_band(void *userdata, int row_start, int row_end)
+{
+    BandJob *job = (BandJob *)userdata;
+    WallBitboard *board = job->dst;
+
+    for (int y = row_start; y < row_end; y++)
+    {
+        uint64_t *row = bitboard_row(board, y);
+        for (int w = 0; w < board->words_per_row; w++)
+            row[w] = 0;
+
+        for (int x = 0; x < board->width; x++)
+        {
+            // Force border to be walls, interior walls keyed by seed and tile position
+            int border = x == 0 || x == board->width - 1 || y == 0 || y == board->height - 1;
+            if (border || rng_range(rng_u32(job->seed, RNG_STREAM_MAP_NOISE, x, y), 100) < job->wall_percent)
+                row[x >> 6] |= (uint64_t)1 << (x & 63);
+        }
+    }
+}
+
+// Random initial walls. Each tile's value depends only on (seed, x, y), so bands fill independently.
+void bitboard_fill_noise(WallBitboard *board, uint32_t seed, int wall_percent)
+{
+    BandJob job = {NULL, board, NULL, seed, wall_percent};
+    job_parallel_for(board->height, MAPGEN_BAND_ROWS, noise_band, &job);
+}
+
+// Horizontal 3-cell wall count for 64 cells at once, as a 2-bit number (s1 s0)
+static inline void row_sum3(const uint64_t *row, int word, int words, uint64_t *s0, uint64_t *s1)
+{
+    uint64_t center = row[word];
+    uint64_t left = (center << 1) | (word > 0 ? row[word - 1] >> 63 : 0);         // cell x - 1
+    uint64_t right = (center >> 1) | (word + 1 < words ? row[word + 1] << 63 : 0); // cell x + 1
+
+    *s0 = left ^ center ^ right;
+    *s1 = (left & center) | (right & (left ^ center));
+}
+
+// One cellular-automata step over rows [row_start, row_end) of dst, reading src.
+// A tile becomes a wall when 5 or more of the 3x3 block around it (itself included)
+// are walls. Border tiles are always walls.
+void bitboard_smooth_rows(const WallBitboard *src, WallBitboard *dst, int row_start, int row_end)
+{
+    int width = src->width;
+    int words = src->words_per_row;
+
+    // Bits for the last column and anything past it
+    uint64_t last_word_mask = (width & 63) ? (((uint64_t)1 << (width & 63)) - 1) : ~(uint64_t)0;
+    uint64_t right_border_bit = (uint64_t)1 << ((width - 1) & 63);
+
+    for (int y = row_start; y < row_end; y++)
+    {
+        uint64_t *out = bitboard_row(dst, y);
+
+        if (y == 0 || y == src->height - 1)
+        {
+            for (int w = 0; w < words; w++)
+                out[w] = ~(uint64_t)0;
+            out[words - 1] &= last_word_mask;
+            continue;
+        }
+
+        const uint64_t *above = bitboard_row(src, y - 1);
+        const uint64_t *row = bitboard_row(src, y);
+        const uint64_t *below = bitboard_row(src, y + 1);
+
+        for (int w = 0; w < words; w++)
+        {
+            uint64_t a0, a1, b0, b1, c0, c1;
+            row_sum3(above, w, words, &a0, &a1);
+            row_sum3(row, w, words, &b0, &b1);
+            row_sum3(below, w, words, &c0, &c1);
+
+            // a + b (0..6) as t2 t1 t0
+            uint64_t t0 = a0 ^ b0;
+            uint64_t k0 = a0 & b0;
+            uint64_t t1 = a1 ^ b1 ^ k0;
+            uint64_t t2 = (a1 & b1) | (k0 & (a1 ^ b1));
+
+            // + c (0..9) as u3 u2 u1 u0
+            uint64_t u0 = t0 ^ c0;
+            uint64_t k1 = t0 & c0;
+            uint64_t u1 = t1 ^ c1 ^ k1;
+            uint64_t k2 = (t1 & c1) | (k1 & (t1 ^ c1));
+            uint64_t u2 = t2 ^ k2;
+            uint64_t u3 = t2 & k2;
+
+            // count >= 5
+            out[w] = u3 | (u2 & (u1 | u0));
+        }
+
+        out[0] |= 1;
+        out[words - 1] |= right_border_bit;
+        out[words - 1] &= last_word_mask;
+    }
+}
+
+static void smooth_band(void *userdata, int row_start, int row_end)
+{
+    BandJob *job = (BandJob *)userdata;
+    bitboard_smooth_rows(job->src, job->dst, row_start, row_end);
+}
+
+// Each iteration runs its bands in parallel. Bands read their halo rows from the previous
+// buffer, which is complete once every band of the previous iteration has finished.
+// The result doesn't depend on the thread count.
+void bitboard_smooth(WallBitboard *board, WallBitboard *scratch, int iterations)
+{
+    for (int i = 0; i < iterations; i++)
+    {
+        BandJob job = {board, scratch, NULL, 0, 0};
+        job_parallel_for(board->height, MAPGEN_BAND_ROWS, smooth_band, &job);
+
+        uint64_t *swap = board->bits;
+        board->bits = scratch->bits;
+        scratch->bits = swap;
+    }
+}
+
+static void expand_band(void *userdata, int row_start, int row_end)
+{
+    BandJob *job = (BandJob *)userdata;
+    expand_rows(job->src, job->map, row_start, row_end);
+}
+
+void bitboard_to_cells(const WallBitboard *board, Map *map)
+{
+    BandJob job = {board, NULL, map, 0, 0};
+    job_parallel_for(board->height, MAPGEN_BAND_ROWS, expand_band, &job);
+}
+
+// Expand rows [row_start, row_end) back into wall/floor cells
+static void expand_rows(const WallBitboard *board, Map *map, int row_start, int row_end)
+{
+    for (int y = row_start; y < row_end; y++)
+    {
+        const uint64_t *row = bitboard_row(board, y);
+
+        // Walkability is the inverted wall row; bits past the width stay clear
+        uint64_t *walkable = &map->walkable[(size_t)y * map->walk_words_per_row];
+        for (int w = 0; w < board->words_per_row; w++)
+            walkable[w] = ~row[w];
+        if (board->width & 63)
+            walkable[board->words_per_row - 1] &= ((uint64_t)1 << (board->width & 63)) - 1;
+
+        for (int x = 0; x < board->width; x++)
+        {
+            Cell *cell = &map->cells[map_cell_index(map, x, y)];
+            if ((row[x >> 6] >> (x & 63)) & 1)
+            {
+                cell->flags = 0;
+                cell->tile_type = TILE_WALL;
+            }
+            else
+            {
+                cell->flags = WALKABLE;
+                cell->tile_type = TILE_FLOOR;
+            }
+        }
+    }
+}
@@ -0,0 +1,545 @@
+#include "path_graph.h"
+#include "job_system.h"
+#include <stdio.h>
+#include <string.h>
+
+static int walkable(const Map *map, int x, int y)
+{
+    return x >= 0 && y >= 0 && x < map->width && y < map->height && map_is_walkable(map, x, y);
+}
+
+static int cluster_of(const PathGraph *graph, int x, int y)
+{
+    return (y >> PATH_CLUSTER_SHIFT) * graph->clusters_w + (x >> PATH_CLUSTER_SHIFT);
+}
+
+// Tile rectangle of the cluster containing (x, y), inclusive
+void path_graph_cluster_bounds(const PathGraph *graph, int x, int y, int *min_x, int *min_y, int *max_x, int *max_y)
+{
+    *min_x = (x >> PATH_CLUSTER_SHIFT) << PATH_CLUSTER_SHIFT;
+    *min_y = (y >> PATH_CLUSTER_SHIFT) << PATH_CLUSTER_SHIFT;
+    *max_x = *min_x + PATH_CLUSTER_SIZE - 1;
+    *max_y = *min_y + PATH_CLUSTER_SIZE - 1;
+    if (*max_x >= graph->map->width)
+        *max_x = graph->map->width - 1;
+    if (*max_y >= graph->map->height)
+        *max_y = graph->map->height - 1;
+}
+
+// Copy the walkability of the cluster containing (x, y) into scratch
+static void load_cluster(const PathGraph *graph, PathClusterScratch *scratch, int x, int y)
+{
+    int min_x, min_y, max_x, max_y;
+    path_graph_cluster_bounds(graph, x, y, &min_x, &min_y, &max_x, &max_y);
+    scratch->min_x = min_x;
+    scratch->min_y = min_y;
+
+    memset(scratch->open, 0, sizeof(scratch->open));
+    for (int ty = min_y; ty <= max_y; ty++)
+    {
+        uint8_t *row = &scratch->open[(ty - min_y + 1) * PATH_CLUSTER_STRIDE + 1];
+        for (int tx = min_x; tx <= max_x; tx++)
+            row[tx - min_x] = map_is_walkable(graph->map, tx, ty) ? 1 : 0;
+    }
+}
+
+static int local_index(const PathClusterScratch *scratch, int x, int y)
+{
+    return (y - scratch->min_y + 1) * PATH_CLUSTER_STRIDE + (x - scratch->min_x + 1);
+}
+
+// Dijkstra inside the loaded cluster from local index from, stopping early once every
+// tile marked in wanted is settled. distance holds PATH_UNREACHABLE where nothing got.
+static void cluster_search(PathClusterScratch *scratch, int from, int wanted_count)
+{
+    static const int steps[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
+
+    for (int i = 0; i < PATH_CLUSTER_STRIDE * PATH_CLUSTER_STRIDE; i++)
+        scratch->distance[i] = PATH_UNREACHABLE;
+    scratch->heap.count = 0;
+    if (!scratch->open[from])
+        return;
+
+    scratch->distance[from] = 0;
+    path_heap_push(&scratch->heap, 0, from);
+
+    while (scratch->heap.count > 0 && wanted_count > 0)
+    {
+        uint32_t f = scratch->heap.entries[0].f;
+        int local = path_heap_pop(&scratch->heap);
+        if (f != scratch->distance[local])
+            continue; // stale duplicate
+        if (scratch->wanted[local])
+            wanted_count -= scratch->wanted[local];
+
+        for (int s = 0; s < 8; s++)
+        {
+            int dx = steps[s][0];
+            int dy = steps[s][1];
+            int next = local + dy * PATH_CLUSTER_STRIDE + dx;
+            if (!scratch->open[next])
+                continue;
+            // Same no corner cutting rule as the grid search
+            if (dx != 0 && dy != 0 && (!scratch->open[local + dx] || !scratch->open[local + dy * PATH_CLUSTER_STRIDE]))
+                continue;
+
+            uint32_t d = f + (dx != 0 && dy != 0 ? PATH_COST_DIAGONAL : PATH_COST_STRAIGHT);
+            if (d < scratch->distance[next])
+            {
+                scratch->distance[next] = d;
+                path_heap_push(&scratch->heap, d, next);
+            }
+        }
+    }
+}
+
+static void add_node(PathCluster *cluster, int x, int y, PathSide side)
+{
+    if (cluster->node_count == PATH_CLUSTER_MAX_NODES)
+        return;
+    PathGraphNode *node = &cluster->nodes[cluster->node_count++];
+    node->x = (int16_t)x;
+    node->y = (int16_t)y;
+    node->side = (uint8_t)side;
+}
+
+// Entrances along one border, walking length tiles from (x, y) by (step_x, step_y)
+// with the facing tile at offset (across_x, across_y). Both clusters of a border scan
+// it the same way, so their entrances always pair up.
+static void add_entrances(PathCluster *cluster, const Map *map, int x, int y, int step_x, int step_y, int length,
+                          int across_x, int across_y, PathSide side)
+{
+    int run_start = -1;
+    for (int i = 0; i <= length; i++)
+    {
+        int tx = x + i * step_x;
+        int ty = y + i * step_y;
+        int open = i < length && walkable(map, tx, ty) && walkable(map, tx + across_x, ty + across_y);
+
+        if (open && run_start < 0)
+        {
+            run_start = i;
+        }
+        else if (!open && run_start >= 0)
+        {
+            int run_end = i - 1;
+            if (run_end - run_start + 1 >= PATH_ENTRANCE_SPLIT)
+            {
+                add_node(cluster, x + run_start * step_x, y + run_start * step_y, side);
+                add_node(cluster, x + run_end * step_x, y + run_end * step_y, side);
+            }
+            else
+            {
+                int mid = (run_start + run_end) / 2;
+                add_node(cluster, x + mid * step_x, y + mid * step_y, side);
+            }
+            run_start = -1;
+        }
+    }
+}
+
+static int add_edge(PathCluster *cluster, int a, int b, uint32_t cost)
+{
+    if (cluster->edge_count == cluster->edge_capacity)
+    {
+        int new_capacity = cluster->edge_capacity > 0 ? cluster->edge_capacity * 2 : 16;
+        PathGraphEdge *grown = realloc(cluster->edges, sizeof(PathGraphEdge) * new_capacity);
+        if (!grown)
+            return -1;
+        cluster->edges = grown;
+        cluster->edge_capacity = new_capacity;
+    }
+    PathGraphEdge *edge = &cluster->edges[cluster->edge_count++];
+    edge->a = (uint8_t)a;
+    edge->b = (uint8_t)b;
+    edge->cost = cost;
+    return 0;
+}
+
+// Recompute one cluster's entrances and the distances between them
+static int build_cluster(PathGraph *graph, int cluster_x, int cluster_y, PathClusterScratch *scratch)
+{
+    const Map *map = graph->map;
+    PathCluster *cluster = &graph->clusters[cluster_y * graph->clusters_w + cluster_x];
+    int min_x, min_y, max_x, max_y;
+    path_graph_cluster_bounds(graph, cluster_x << PATH_CLUSTER_SHIFT, cluster_y << PATH_CLUSTER_SHIFT,
+                              &min_x, &min_y, &max_x, &max_y);
+    int width = max_x - min_x + 1;
+    int height = max_y - min_y + 1;
+
+    cluster->node_count = 0;
+    cluster->edge_count = 0;
+    if (min_x > 0)
+        add_entrances(cluster, map, min_x, min_y, 0, 1, height, -1, 0, PATH_SIDE_LEFT);
+    if (max_x < map->width - 1)
+        add_entrances(cluster, map, max_x, min_y, 0, 1, height, 1, 0, PATH_SIDE_RIGHT);
+    if (min_y > 0)
+        add_entrances(cluster, map, min_x, min_y, 1, 0, width, 0, -1, PATH_SIDE_TOP);
+    if (max_y < map->height - 1)
+        add_entrances(cluster, map, min_x, max_y, 1, 0, width, 0, 1, PATH_SIDE_BOTTOM);
+
+    // One search per entrance finds its distance to every later one
+    load_cluster(graph, scratch, min_x, min_y);
+    memset(scratch->wanted, 0, sizeof(scratch->wanted));
+    for (int k = 0; k < cluster->node_count; k++)
+        scratch->wanted[local_index(scratch, cluster->nodes[k].x, cluster->nodes[k].y)]++;
+
+    int failed = 0;
+    for (int a = 0; a + 1 < cluster->node_count && !failed; a++)
+    {
+        scratch->wanted[local_index(scratch, cluster->nodes[a].x, cluster->nodes[a].y)]--;
+        cluster_search(scratch, local_index(scratch, cluster->nodes[a].x, cluster->nodes[a].y),
+                       cluster->node_count - a - 1);
+        for (int b = a + 1; b < cluster->node_count; b++)
+        {
+            uint32_t cost = scratch->distance[local_index(scratch, cluster->nodes[b].x, cluster->nodes[b].y)];
+            if (cost != PATH_UNREACHABLE && add_edge(cluster, a, b, cost) != 0)
+            {
+                printf("Unable to grow path graph edges!\n");
+                failed = 1;
+                break;
+            }
+        }
+    }
+    memset(scratch->wanted, 0, sizeof(scratch->wanted));
+    return failed ? -1 : 0;
+}
+
+// Rows of clusters are independent, each range brings its own search scratch
+static void build_rows(void *userdata, int row_start, int row_end)
+{
+    PathGraph *graph = (PathGraph *)userdata;
+    PathClusterScratch *scratch = (PathClusterScratch *)calloc(1, sizeof(PathClusterScratch));
+    if (!scratch)
+    {
+        printf("Unable to allocate path graph scratch!\n");
+        SDL_AtomicSet(&graph->failed, 1);
+        return;
+    }
+
+    for (int cy = row_start; cy < row_end && !SDL_AtomicGet(&graph->failed); cy++)
+    {
+        for (int cx = 0; cx < graph->clusters_w; cx++)
+        {
+            if (build_cluster(graph, cx, cy, scratch) != 0)
+            {
+                SDL_AtomicSet(&graph->failed, 1);
+                break;
+            }
+        }
+    }
+    free(scratch->heap.entries);
+    free(scratch);
+}
+
+PathGraph *path_graph_create(const Map *map)
+{
+    PathGraph *graph = (PathGraph *)calloc(1, sizeof(PathGraph));
+    if (!graph)
+        return NULL;
+
+    graph->map = map;
+    graph->clusters_w = (map->width + PATH_CLUSTER_SIZE - 1) >> PATH_CLUSTER_SHIFT;
+    graph->clusters_h = (map->height + PATH_CLUSTER_SIZE - 1) >> PATH_CLUSTER_SHIFT;
+    int cluster_count = graph->clusters_w * graph->clusters_h;
+    graph->node_ids = cluster_count * PATH_CLUSTER_MAX_NODES + 2;
+
+    graph->clusters = calloc(cluster_count, sizeof(PathCluster));
+    graph->g = malloc(sizeof(uint32_t) * graph->node_ids);
+    graph->parent = malloc(sizeof(int) * graph->node_ids);
+    graph->stamp = calloc(graph->node_ids, sizeof(uint32_t));
+    graph->closed = malloc(graph->node_ids);
+    if (!graph->clusters || !graph->g || !graph->parent || !graph->stamp || !graph->closed)
+    {
+        printf("Unable to allocate path graph!\n");
+        path_graph_destroy(graph);
+        return NULL;
+    }
+
+    job_parallel_for(graph->clusters_h, 1, build_rows, graph);
+    if (SDL_AtomicGet(&graph->failed))
+    {
+        path_graph_destroy(graph);
+        return NULL;
+    }
+    return graph;
+}
+
+void path_graph_destroy(PathGraph *graph)
+{
+    if (!graph)
+        return;
+    if (graph->clusters)
+    {
+        for (int i = 0; i < graph->clusters_w * graph->clusters_h; i++)
+            free(graph->clusters[i].edges);
+    }
+    free(graph->clusters);
+    free(graph->g);
+    free(graph->parent);
+    free(graph->stamp);
+    free(graph->closed);
+    free(graph->open.entries);
+    free(graph->local.heap.entries);
+    free(graph->route);
+    free(graph);
+}
+
+// Call after changing a tile's walkability. Its own cluster always changes; a tile on a
+// border also changes the entrances of the cluster across. Returns -1 if a cluster could
+// not be rebuilt, after which the graph must not be searched.
+int path_graph_update_tile(PathGraph *graph, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= graph->map->width || y >= graph->map->height)
+        return 0;
+
+    int cluster_x = x >> PATH_CLUSTER_SHIFT;
+    int cluster_y = y >> PATH_CLUSTER_SHIFT;
+    int local_x = x & (PATH_CLUSTER_SIZE - 1);
+    int local_y = y & (PATH_CLUSTER_SIZE - 1);
+
+    int result = build_cluster(graph, cluster_x, cluster_y, &graph->local);
+    if (local_x == 0 && cluster_x > 0)
+        result |= build_cluster(graph, cluster_x - 1, cluster_y, &graph->local);
+    if (local_x == PATH_CLUSTER_SIZE - 1 && cluster_x < graph->clusters_w - 1)
+        result |= build_cluster(graph, cluster_x + 1, cluster_y, &graph->local);
+    if (local_y == 0 && cluster_y > 0)
+        result |= build_cluster(graph, cluster_x, cluster_y - 1, &graph->local);
+    if (local_y == PATH_CLUSTER_SIZE - 1 && cluster_y < graph->clusters_h - 1)
+        result |= build_cluster(graph, cluster_x, cluster_y + 1, &graph->local);
+    if (result != 0)
+        SDL_AtomicSet(&graph->failed, 1);
+    return result;
+}
+
+// The entrance node facing this one from the neighbouring cluster, -1 if none
+static int partner_of(const PathGraph *graph, int cluster, const PathGraphNode *node)
+{
+    int cluster_x = cluster % graph->clusters_w;
+    int cluster_y = cluster / graph->clusters_w;
+    int x = node->x, y = node->y;
+    int side;
+
+    switch (node->side)
+    {
+    case PATH_SIDE_LEFT:
+        cluster_x--, x--, side = PATH_SIDE_RIGHT;
+        break;
+    case PATH_SIDE_RIGHT:
+        cluster_x++, x++, side = PATH_SIDE_LEFT;
+        break;
+    case PATH_SIDE_TOP:
+        cluster_y--, y--, side = PATH_SIDE_BOTTOM;
+        break;
+    default:
+        cluster_y++, y++, side = PATH_SIDE_TOP;
+        break;
+    }
+
+    int other = cluster_y * graph->clusters_w + cluster_x;
+    const PathCluster *facing = &graph->clusters[other];
+    for (int k = 0; k < facing->node_count; k++)
+    {
+        if (facing->nodes[k].x == x && facing->nodes[k].y == y && facing->nodes[k].side == side)
+            return other * PATH_CLUSTER_MAX_NODES + k;
+    }
+    return -1;
+}
+
+static void node_position(const PathGraph *graph, int id, int start_x, int start_y, int goal_x, int goal_y,
+                          int *x, int *y)
+{
+    if (id == graph->node_ids - 2)
+    {
+        *x = start_x, *y = start_y;
+    }
+    else if (id == graph->node_ids - 1)
+    {
+        *x = goal_x, *y = goal_y;
+    }
+    else
+    {
+        const PathGraphNode *node = &graph->clusters[id / PATH_CLUSTER_MAX_NODES].nodes[id % PATH_CLUSTER_MAX_NODES];
+        *x = node->x, *y = node->y;
+    }
+}
+
+static int build_route(PathGraph *graph, int start_x, int start_y, int goal_x, int goal_y)
+{
+    int total = 0;
+    for (int id = graph->node_ids - 1; id >= 0; id = graph->parent[id])
+        total++;
+
+    if (total > graph->route_capacity)
+    {
+        int new_capacity = graph->route_capacity > 0 ? graph->route_capacity : 64;
+        while (new_capacity < total)
+            new_capacity *= 2;
+        PathGraphNode *grown = realloc(graph->route, sizeof(PathGraphNode) * new_capacity);
+        if (!grown)
+            return 0;
+        graph->route = grown;
+        graph->route_capacity = new_capacity;
+    }
+
+    int i = total - 1;
+    for (int id = graph->node_ids - 1; id >= 0; id = graph->parent[id], i--)
+    {
+        int x, y;
+        node_position(graph, id, start_x, start_y, goal_x, goal_y, &x, &y);
+        graph->route[i].x = (int16_t)x;
+        graph->route[i].y = (int16_t)y;
+        graph->route[i].side = 0;
+    }
+    graph->route_count = total;
+    return 1;
+}
+
+// Distances from (x, y) to each entrance of its cluster, and to (other_x, other_y) when
+// include_other is set. Searches are undirected, so this serves the goal side as well.
+static void join_cluster(PathGraph *graph, const PathCluster *cluster, int x, int y, int include_other,
+                         int other_x, int other_y, uint32_t *costs, uint32_t *other_cost)
+{
+    PathClusterScratch *scratch = &graph->local;
+    load_cluster(graph, scratch, x, y);
+    memset(scratch->wanted, 0, sizeof(scratch->wanted));
+
+    int wanted_count = cluster->node_count;
+    for (int k = 0; k < cluster->node_count; k++)
+        scratch->wanted[local_index(scratch, cluster->nodes[k].x, cluster->nodes[k].y)]++;
+    if (include_other)
+    {
+        scratch->wanted[local_index(scratch, other_x, other_y)]++;
+        wanted_count++;
+    }
+
+    cluster_search(scratch, local_index(scratch, x, y), wanted_count);
+    for (int k = 0; k < cluster->node_count; k++)
+        costs[k] = scratch->distance[local_index(scratch, cluster->nodes[k].x, cluster->nodes[k].y)];
+    if (include_other)
+        *other_cost = scratch->distance[local_index(scratch, other_x, other_y)];
+    memset(scratch->wanted, 0, sizeof(scratch->wanted));
+}
+
+// A* over the entrances. Start and goal join the graph through the entrances of their
+// own clusters; on success graph->route holds start, each entrance on the way and goal.
+// Consecutive route tiles are either in one cluster or one straight step apart.
+// Returns 1 when found, 0 when there is no path and -1 when max_expansions ran out.
+int path_graph_find(PathGraph *graph, int start_x, int start_y, int goal_x, int goal_y, int max_expansions,
+                    int *expansions)
+{
+    graph->route_count = 0;
+    int start_cluster = cluster_of(graph, start_x, start_y);
+    int goal_cluster = cluster_of(graph, goal_x, goal_y);
+    const PathCluster *start_nodes = &graph->clusters[start_cluster];
+    const PathCluster *goal_nodes = &graph->clusters[goal_cluster];
+
+    uint32_t direct_cost = PATH_UNREACHABLE;
+    join_cluster(graph, start_nodes, start_x, start_y, start_cluster == goal_cluster, goal_x, goal_y,
+                 graph->start_cost, &direct_cost);
+    join_cluster(graph, goal_nodes, goal_x, goal_y, 0, 0, 0, graph->goal_cost, NULL);
+
+    if (++graph->query_stamp == 0)
+    {
+        memset(graph->stamp, 0, sizeof(uint32_t) * graph->node_ids);
+        graph->query_stamp = 1;
+    }
+    graph->open.count = 0;
+
+    int start_id = graph->node_ids - 2;
+    int goal_id = graph->node_ids - 1;
+    graph->stamp[start_id] = graph->query_stamp;
+    graph->g[start_id] = 0;
+    graph->parent[start_id] = -1;
+    graph->closed[start_id] = 0;
+    path_heap_push(&graph->open, path_octile(start_x, start_y, goal_x, goal_y), start_id);
+
+    // Every edge leaving the node being expanded
+    int targets[PATH_CLUSTER_MAX_NODES * 2 + 1];
+    uint32_t costs[PATH_CLUSTER_MAX_NODES * 2 + 1];
+
+    int used = 0;
+    while (graph->open.count > 0)
+    {
+        int id = path_heap_pop(&graph->open);
+        if (graph->closed[id])
+            continue;
+        if (used == max_expansions)
+            return -1;
+        graph->closed[id] = 1;
+        used++;
+        (*expansions)++;
+
+        if (id == goal_id)
+            return build_route(graph, start_x, start_y, goal_x, goal_y);
+
+        int target_count = 0;
+        if (id == start_id)
+        {
+            for (int k = 0; k < start_nodes->node_count; k++)
+            {
+                if (graph->start_cost[k] == PATH_UNREACHABLE)
+                    continue;
+                targets[target_count] = start_cluster * PATH_CLUSTER_MAX_NODES + k;
+                costs[target_count++] = graph->start_cost[k];
+            }
+            if (direct_cost != PATH_UNREACHABLE)
+            {
+                targets[target_count] = goal_id;
+                costs[target_count++] = direct_cost;
+            }
+        }
+        else
+        {
+            int cluster = id / PATH_CLUSTER_MAX_NODES;
+            int k = id % PATH_CLUSTER_MAX_NODES;
+            const PathCluster *c = &graph->clusters[cluster];
+
+            for (int e = 0; e < c->edge_count; e++)
+            {
+                const PathGraphEdge *edge = &c->edges[e];
+                if (edge->a != k && edge->b != k)
+                    continue;
+                targets[target_count] = cluster * PATH_CLUSTER_MAX_NODES + (edge->a == k ? edge->b : edge->a);
+                costs[target_count++] = edge->cost;
+            }
+
+            int partner = partner_of(graph, cluster, &c->nodes[k]);
+            if (partner >= 0)
+            {
+                targets[target_count] = partner;
+                costs[target_count++] = PATH_COST_STRAIGHT;
+            }
+
+            if (cluster == goal_cluster && graph->goal_cost[k] != PATH_UNREACHABLE)
+            {
+                targets[target_count] = goal_id;
+                costs[target_count++] = graph->goal_cost[k];
+            }
+        }
+
+        for (int t = 0; t < target_count; t++)
+        {
+            int next = targets[t];
+            uint32_t g = graph->g[id] + costs[t];
+            if (graph->stamp[next] == graph->query_stamp)
+            {
+                if (graph->closed[next] || g >= graph->g[next])
+                    continue;
+            }
+            else
+            {
+                graph->stamp[next] = graph->query_stamp;
+                graph->closed[next] = 0;
+            }
+
+            int x, y;
+            node_position(graph, next, start_x, start_y, goal_x, goal_y, &x, &y);
+            graph->g[next] = g;
+            graph->parent[next] = id;
+            if (path_heap_push(&graph->open, g + path_octile(x, y, goal_x, goal_y), next) != 0)
+                return 0;
+        }
+    }
+    return 0;
+}
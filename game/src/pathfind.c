@@ -0,0 +1,513 @@
+#include "pathfind.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SEARCH_CUT_OFF -2
+
+Pathfinder *pathfinder_create(const Map *map)
+{
+    Pathfinder *pf = (Pathfinder *)calloc(1, sizeof(Pathfinder));
+    if (!pf)
+        return NULL;
+
+    size_t size = (size_t)map->width * map->height;
+    pf->map = map;
+    pf->width = map->width;
+    pf->height = map->height;
+    pf->g = malloc(sizeof(uint32_t) * size);
+    pf->parent = malloc(sizeof(int) * size);
+    pf->stamp = calloc(size, sizeof(uint32_t));
+    pf->closed = malloc(size);
+    pf->cache = calloc(PATH_CACHE_SIZE, sizeof(PathCacheEntry));
+    pf->frame_budget = PATH_MAX_EXPANSIONS;
+
+    if (!pf->g || !pf->parent || !pf->stamp || !pf->closed || !pf->cache)
+    {
+        printf("Unable to allocate pathfinder buffers!\n");
+        pathfinder_destroy(pf);
+        return NULL;
+    }
+
+    // Without the cluster graph every search runs flat on the grid
+    pf->graph = path_graph_create(map);
+    if (!pf->graph)
+        printf("Unable to build path graph, long paths will use grid search!\n");
+    return pf;
+}
+
+void pathfinder_destroy(Pathfinder *pf)
+{
+    if (!pf)
+        return;
+    free(pf->g);
+    free(pf->parent);
+    free(pf->stamp);
+    free(pf->closed);
+    free(pf->open.entries);
+    free(pf->cache);
+    path_graph_destroy(pf->graph);
+    free(pf);
+}
+
+// Searches started this frame may expand this many nodes in total
+void pathfinder_begin_frame(Pathfinder *pf, int expansion_budget)
+{
+    pf->frame_budget = expansion_budget;
+    pf->frame_expansions = 0;
+}
+
+// Open and inside the current search window
+static int walkable(const Pathfinder *pf, int x, int y)
+{
+    return x >= pf->min_x && y >= pf->min_y && x <= pf->max_x && y <= pf->max_y && map_is_walkable(pf->map, x, y);
+}
+
+// Walk from (x, y) in direction (dx, dy) until a jump point, the goal or a dead end.
+// A straight run stops next to an opening that a diagonal from behind couldn't reach
+// (a forced neighbour); a diagonal run stops where either straight run finds something.
+static int jump(const Pathfinder *pf, int x, int y, int dx, int dy, int *jump_x, int *jump_y)
+{
+    while (1)
+    {
+        if (!walkable(pf, x, y))
+            return 0;
+        if (x == pf->goal_x && y == pf->goal_y)
+            break;
+
+        if (dx != 0 && dy != 0)
+        {
+            int ix, iy;
+            if (jump(pf, x + dx, y, dx, 0, &ix, &iy) || jump(pf, x, y + dy, 0, dy, &ix, &iy))
+                break;
+            if (!walkable(pf, x + dx, y) || !walkable(pf, x, y + dy))
+                return 0;
+        }
+        else if (dx != 0)
+        {
+            if ((walkable(pf, x, y - 1) && !walkable(pf, x - dx, y - 1)) ||
+                (walkable(pf, x, y + 1) && !walkable(pf, x - dx, y + 1)))
+                break;
+        }
+        else
+        {
+            if ((walkable(pf, x - 1, y) && !walkable(pf, x - 1, y - dy)) ||
+                (walkable(pf, x + 1, y) && !walkable(pf, x + 1, y - dy)))
+                break;
+        }
+
+        x += dx;
+        y += dy;
+    }
+
+    *jump_x = x;
+    *jump_y = y;
+    return 1;
+}
+
+static int sign(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+// Directions worth jumping in from a node reached travelling (dx, dy); all legal
+// directions at the start node. Returns how many were written to dirs.
+static int prune_directions(const Pathfinder *pf, int x, int y, int dx, int dy, int dirs[8][2])
+{
+    int n = 0;
+#define ADD_DIR(ax, ay) (dirs[n][0] = (ax), dirs[n][1] = (ay), n++)
+
+    if (dx == 0 && dy == 0)
+    {
+        for (int ny = -1; ny <= 1; ny++)
+        {
+            for (int nx = -1; nx <= 1; nx++)
+            {
+                if ((nx == 0 && ny == 0) || !walkable(pf, x + nx, y + ny))
+                    continue;
+                if (nx != 0 && ny != 0 && (!walkable(pf, x + nx, y) || !walkable(pf, x, y + ny)))
+                    continue;
+                ADD_DIR(nx, ny);
+            }
+        }
+    }
+    else if (dx != 0 && dy != 0)
+    {
+        int open_x = walkable(pf, x + dx, y);
+        int open_y = walkable(pf, x, y + dy);
+        if (open_y)
+            ADD_DIR(0, dy);
+        if (open_x)
+            ADD_DIR(dx, 0);
+        if (open_x && open_y)
+            ADD_DIR(dx, dy);
+    }
+    else if (dx != 0)
+    {
+        int open_next = walkable(pf, x + dx, y);
+        int open_up = walkable(pf, x, y - 1);
+        int open_down = walkable(pf, x, y + 1);
+        if (open_next)
+        {
+            ADD_DIR(dx, 0);
+            if (open_up)
+                ADD_DIR(dx, -1);
+            if (open_down)
+                ADD_DIR(dx, 1);
+        }
+        if (open_up)
+            ADD_DIR(0, -1);
+        if (open_down)
+            ADD_DIR(0, 1);
+    }
+    else
+    {
+        int open_next = walkable(pf, x, y + dy);
+        int open_left = walkable(pf, x - 1, y);
+        int open_right = walkable(pf, x + 1, y);
+        if (open_next)
+        {
+            ADD_DIR(0, dy);
+            if (open_left)
+                ADD_DIR(-1, dy);
+            if (open_right)
+                ADD_DIR(1, dy);
+        }
+        if (open_left)
+            ADD_DIR(-1, 0);
+        if (open_right)
+            ADD_DIR(1, 0);
+    }
+
+#undef ADD_DIR
+    return n;
+}
+
+// Append the jump points of the last search. A non-empty entry already ends on the
+// search's start, so that point is skipped; whatever doesn't fit is dropped.
+static void append_path(Pathfinder *pf, PathCacheEntry *entry, int goal)
+{
+    int total = 0;
+    for (int node = goal; node >= 0; node = pf->parent[node])
+        total++;
+
+    int first = entry->count > 0 ? 1 : 0;
+
+    // Chain index i lands at points[entry->count + i - first]
+    int base = entry->count - first;
+    int end = total;
+    if (base + end > PATH_MAX_POINTS)
+        end = PATH_MAX_POINTS - base;
+
+    int i = total - 1;
+    for (int node = goal; node >= 0; node = pf->parent[node], i--)
+    {
+        if (i < first || i >= end)
+            continue;
+        entry->points[base + i].x = (int16_t)(node % pf->width);
+        entry->points[base + i].y = (int16_t)(node / pf->width);
+    }
+    if (end > first)
+        entry->count = base + end;
+}
+
+static void compute_bounds(PathCacheEntry *entry)
+{
+    entry->min_x = entry->max_x = entry->points[0].x;
+    entry->min_y = entry->max_y = entry->points[0].y;
+    for (int k = 1; k < entry->count; k++)
+    {
+        if (entry->points[k].x < entry->min_x)
+            entry->min_x = entry->points[k].x;
+        if (entry->points[k].x > entry->max_x)
+            entry->max_x = entry->points[k].x;
+        if (entry->points[k].y < entry->min_y)
+            entry->min_y = entry->points[k].y;
+        if (entry->points[k].y > entry->max_y)
+            entry->max_y = entry->points[k].y;
+    }
+}
+
+static void set_window(Pathfinder *pf, int min_x, int min_y, int max_x, int max_y)
+{
+    pf->min_x = min_x;
+    pf->min_y = min_y;
+    pf->max_x = max_x;
+    pf->max_y = max_y;
+}
+
+// Grid search inside the current window, expanding at most max_expansions nodes.
+// Returns the goal's node index, with the parent chain leading back to the start,
+// -1 when there is no path or SEARCH_CUT_OFF when the limit stopped it first.
+static int search(Pathfinder *pf, int start_x, int start_y, int goal_x, int goal_y, int max_expansions)
+{
+    // New stamp marks every tile untouched; on wrap-around clear for real
+    if (++pf->query_stamp == 0)
+    {
+        memset(pf->stamp, 0, sizeof(uint32_t) * pf->width * pf->height);
+        pf->query_stamp = 1;
+    }
+    pf->open.count = 0;
+    pf->goal_x = goal_x;
+    pf->goal_y = goal_y;
+
+    int start = start_y * pf->width + start_x;
+    int goal = goal_y * pf->width + goal_x;
+    pf->stamp[start] = pf->query_stamp;
+    pf->g[start] = 0;
+    pf->parent[start] = -1;
+    pf->closed[start] = 0;
+    path_heap_push(&pf->open, path_octile(start_x, start_y, goal_x, goal_y), start);
+
+    int expansions = 0;
+    int found = -1;
+    while (pf->open.count > 0)
+    {
+        int node = path_heap_pop(&pf->open);
+        if (pf->closed[node])
+            continue; // stale duplicate
+        if (expansions == max_expansions)
+        {
+            found = SEARCH_CUT_OFF;
+            break;
+        }
+        pf->closed[node] = 1;
+        expansions++;
+
+        if (node == goal)
+        {
+            found = goal;
+            break;
+        }
+
+        int x = node % pf->width;
+        int y = node / pf->width;
+        int dx = 0, dy = 0;
+        if (pf->parent[node] >= 0)
+        {
+            dx = sign(x - pf->parent[node] % pf->width);
+            dy = sign(y - pf->parent[node] / pf->width);
+        }
+
+        int dirs[8][2];
+        int dir_count = prune_directions(pf, x, y, dx, dy, dirs);
+        for (int d = 0; d < dir_count; d++)
+        {
+            int jx, jy;
+            if (!jump(pf, x + dirs[d][0], y + dirs[d][1], dirs[d][0], dirs[d][1], &jx, &jy))
+                continue;
+
+            int next = jy * pf->width + jx;
+            uint32_t g = pf->g[node] + path_octile(x, y, jx, jy);
+            if (pf->stamp[next] == pf->query_stamp)
+            {
+                if (pf->closed[next] || g >= pf->g[next])
+                    continue;
+            }
+            else
+            {
+                pf->stamp[next] = pf->query_stamp;
+                pf->closed[next] = 0;
+            }
+
+            pf->g[next] = g;
+            pf->parent[next] = node;
+            if (path_heap_push(&pf->open, g + path_octile(jx, jy, goal_x, goal_y), next) != 0)
+            {
+                pf->open.count = 0;
+                break;
+            }
+        }
+    }
+
+    pf->frame_expansions += expansions;
+    return found;
+}
+
+// Route over the cluster graph, then refine it leg by leg until the entry is full.
+// Legs inside one cluster are searched on the grid within that cluster; legs between
+// clusters are the single straight step across an entrance. All of it shares one
+// limit of max_expansions.
+static PathStatus search_hierarchical(Pathfinder *pf, PathCacheEntry *entry, int max_expansions)
+{
+    PathGraph *graph = pf->graph;
+    int stop = pf->frame_expansions + max_expansions;
+    int routed = path_graph_find(graph, entry->start_x, entry->start_y, entry->goal_x, entry->goal_y, max_expansions,
+                                 &pf->frame_expansions);
+    if (routed < 0)
+        return PATH_DEFERRED;
+    if (routed == 0)
+        return PATH_NOT_FOUND;
+
+    entry->count = 1;
+    entry->points[0].x = (int16_t)entry->start_x;
+    entry->points[0].y = (int16_t)entry->start_y;
+
+    for (int r = 1; r < graph->route_count && entry->count < PATH_MAX_POINTS; r++)
+    {
+        const PathGraphNode *from = &graph->route[r - 1];
+        const PathGraphNode *to = &graph->route[r];
+        if (from->x == to->x && from->y == to->y)
+            continue;
+
+        if ((from->x >> PATH_CLUSTER_SHIFT) != (to->x >> PATH_CLUSTER_SHIFT) ||
+            (from->y >> PATH_CLUSTER_SHIFT) != (to->y >> PATH_CLUSTER_SHIFT))
+        {
+            entry->points[entry->count].x = to->x;
+            entry->points[entry->count].y = to->y;
+            entry->count++;
+            continue;
+        }
+
+        int min_x, min_y, max_x, max_y;
+        path_graph_cluster_bounds(graph, from->x, from->y, &min_x, &min_y, &max_x, &max_y);
+        set_window(pf, min_x, min_y, max_x, max_y);
+        int goal = search(pf, from->x, from->y, to->x, to->y, stop - pf->frame_expansions);
+        if (goal == SEARCH_CUT_OFF)
+            return PATH_DEFERRED;
+        if (goal < 0)
+            break; // graph out of date with the map; keep what was refined
+        append_path(pf, entry, goal);
+    }
+    if (entry->count > 1 || (entry->start_x == entry->goal_x && entry->start_y == entry->goal_y))
+        return PATH_FOUND;
+    return PATH_NOT_FOUND;
+}
+
+static void invalidate_entry(PathCacheEntry *entry)
+{
+    entry->valid = 0;
+    entry->generation++;
+}
+
+static int cache_slot(int start_x, int start_y, int goal_x, int goal_y)
+{
+    uint32_t h = (uint32_t)start_x * 73856093u ^ (uint32_t)start_y * 19349663u ^
+                 (uint32_t)goal_x * 83492791u ^ (uint32_t)goal_y * 2654435761u;
+    return (int)(h & (PATH_CACHE_SIZE - 1));
+}
+
+// Path from start to goal tile, from the cache when possible. On PATH_FOUND and
+// PATH_NOT_FOUND, *handle refers to the cached result. A search gets what is left of
+// the frame budget; one that runs out is dropped and deferred, unless it had the full
+// allowance, in which case it will never fit and is cached as not found.
+PathStatus pathfinder_request(Pathfinder *pf, int start_x, int start_y, int goal_x, int goal_y, PathHandle *handle)
+{
+    int slot = cache_slot(start_x, start_y, goal_x, goal_y);
+    PathCacheEntry *entry = &pf->cache[slot];
+    handle->slot = slot;
+
+    if (entry->valid && entry->start_x == start_x && entry->start_y == start_y &&
+        entry->goal_x == goal_x && entry->goal_y == goal_y)
+    {
+        handle->generation = entry->generation;
+        return entry->found ? PATH_FOUND : PATH_NOT_FOUND;
+    }
+
+    set_window(pf, 0, 0, pf->width - 1, pf->height - 1);
+    if (!walkable(pf, start_x, start_y) || !walkable(pf, goal_x, goal_y))
+        return PATH_NOT_FOUND;
+    int allowance = pf->frame_budget < PATH_MAX_EXPANSIONS ? pf->frame_budget : PATH_MAX_EXPANSIONS;
+    int limit = pf->frame_budget - pf->frame_expansions;
+    if (limit > allowance)
+        limit = allowance;
+    if (limit <= 0)
+        return PATH_DEFERRED;
+
+    // Replace whatever held the slot
+    entry->generation++;
+    entry->valid = 1;
+    entry->start_x = start_x;
+    entry->start_y = start_y;
+    entry->goal_x = goal_x;
+    entry->goal_y = goal_y;
+    entry->count = 0;
+
+    PathStatus status;
+    if (pf->graph && path_octile(start_x, start_y, goal_x, goal_y) > PATH_HIERARCHY_DISTANCE)
+    {
+        status = search_hierarchical(pf, entry, limit);
+    }
+    else
+    {
+        int goal = search(pf, start_x, start_y, goal_x, goal_y, limit);
+        status = goal >= 0 ? PATH_FOUND : goal == SEARCH_CUT_OFF ? PATH_DEFERRED : PATH_NOT_FOUND;
+        if (status == PATH_FOUND)
+            append_path(pf, entry, goal);
+    }
+    if (status == PATH_DEFERRED)
+    {
+        if (limit < allowance)
+        {
+            invalidate_entry(entry);
+            return PATH_DEFERRED;
+        }
+        status = PATH_NOT_FOUND;
+        entry->count = 0;
+    }
+
+    entry->found = status == PATH_FOUND;
+    if (entry->found)
+        compute_bounds(entry);
+    handle->generation = entry->generation;
+    return entry->found ? PATH_FOUND : PATH_NOT_FOUND;
+}
+
+// The cached result behind a handle, or NULL once it was replaced or invalidated
+const PathCacheEntry *pathfinder_get(const Pathfinder *pf, PathHandle handle)
+{
+    if (handle.slot < 0 || handle.slot >= PATH_CACHE_SIZE)
+        return NULL;
+    const PathCacheEntry *entry = &pf->cache[handle.slot];
+    if (!entry->valid || entry->generation != handle.generation)
+        return NULL;
+    return entry;
+}
+
+// Call after changing a tile's walkability. Drops paths whose bounds touch the tile
+// (a new wall can only block those) and every "no path" result (a new opening could
+// connect anything).
+void pathfinder_invalidate_tile(Pathfinder *pf, int x, int y)
+{
+    for (int i = 0; i < PATH_CACHE_SIZE; i++)
+    {
+        PathCacheEntry *entry = &pf->cache[i];
+        if (!entry->valid)
+            continue;
+        if (!entry->found ||
+            (x >= entry->min_x - 1 && x <= entry->max_x + 1 && y >= entry->min_y - 1 && y <= entry->max_y + 1))
+        {
+            invalidate_entry(entry);
+        }
+    }
+    if (pf->graph && path_graph_update_tile(pf->graph, x, y) != 0)
+    {
+        printf("Unable to update path graph, long paths will use grid search!\n");
+        path_graph_destroy(pf->graph);
+        pf->graph = NULL;
+    }
+}
+
+void pathfinder_invalidate_all(Pathfinder *pf)
+{
+    for (int i = 0; i < PATH_CACHE_SIZE; i++)
+    {
+        if (pf->cache[i].valid)
+            invalidate_entry(&pf->cache[i]);
+    }
+}
+
+// Call after many tiles changed at once, where invalidating them one by one would
+// cost more than starting over: drops every path and the cluster graph, and builds
+// the graph again only if asked, as that walks the whole map
+void pathfinder_rebuild(Pathfinder *pf, int build_graph)
+{
+    pathfinder_invalidate_all(pf);
+    path_graph_destroy(pf->graph);
+    pf->graph = NULL;
+    if (!build_graph)
+        return;
+    pf->graph = path_graph_create(pf->map);
+    if (!pf->graph)
+        printf("Unable to build path graph, long paths will use grid search!\n");
+}
@@ -12,7 +12,9 @@ void player_init(Player *player, float x, float y)
     player->body.speed = 500.0f; // pixels per second
     player->body.vx = 0.0f;
     player->body.vy = 0.0f;
+    player->body.radius = COLLISION_DEFAULT_RADIUS;
     player->body.sprite_id = 0;
+    body_store_previous(&player->body);
 
     player->health = 100;
     player->mana = 50;
@@ -20,7 +22,7 @@ void player_init(Player *player, float x, float y)
     player->experience = 0;
 }
 
-void player_update(Player *player, float timestep, Camera *camera, Map *map)
+void player_update(Player *player, float timestep, Camera *camera, const CollisionField *collision)
 {
     const Uint8 *keyboard = SDL_GetKeyboardState(NULL);
     float stepx = 0.0f;
@@ -51,33 +53,7 @@ void player_update(Player *player, float timestep, Camera *camera, Map *map)
         player->body.vy = 0;
     }
 
-    // Calculate new position (only declare once!)
-    float new_x = player->body.x + player->body.vx * timestep;
-    float new_y = player->body.y + player->body.vy * timestep;
-
-    // Check X movement collision
-    int tile_x = (int)(new_x / TILE_SIZE);
-    int tile_y = (int)(player->body.y / TILE_SIZE);
-    if (tile_x >= 0 && tile_x < map->width && tile_y >= 0 && tile_y < map->height)
-    {
-        Cell *cell = get_cell(map, tile_x, tile_y);
-        if (is_walkable(cell))
-        {
-            player->body.x = new_x;
-        }
-    }
-
-    // Check Y movement collision
-    tile_x = (int)(player->body.x / TILE_SIZE);
-    tile_y = (int)(new_y / TILE_SIZE);
-    if (tile_x >= 0 && tile_x < map->width && tile_y >= 0 && tile_y < map->height)
-    {
-        Cell *cell = get_cell(map, tile_x, tile_y);
-        if (is_walkable(cell))
-        {
-            player->body.y = new_y;
-        }
-    }
+    collision_move_body(collision, &player->body, timestep);
 
     // Convert mouse screen coordinates to world coordinates
     int mouse_screen_x, mouse_screen_y;
@@ -93,33 +69,3 @@ void player_update(Player *player, float timestep, Camera *camera, Map *map)
     // Calculate rotation angle in degrees
     player->body.rotation = atan2f(stepy, stepx) * (180.0f / 3.14159f);
 }
-
-int can_move_to_with_size(Map *map, float center_x, float center_y, float player_radius)
-{
-    // Check multiple points around the player
-    float offsets[] = {-player_radius, 0, player_radius};
-
-    for (int i = 0; i < 3; i++)
-    {
-        for (int j = 0; j < 3; j++)
-        {
-            float check_x = center_x + offsets[i];
-            float check_y = center_y + offsets[j];
-
-            int tile_x = (int)(check_x / TILE_SIZE);
-            int tile_y = (int)(check_y / TILE_SIZE);
-
-            if (tile_x < 0 || tile_x >= map->width || tile_y < 0 || tile_y >= map->height)
-            {
-                return 0;
-            }
-
-            Cell *cell = get_cell(map, tile_x, tile_y);
-            if (!is_walkable(cell))
-            {
-                return 0;
-            }
-        }
-    }
-    return 1;
-}
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "spatial_hash.h"
+#include <math.h>
+#include <string.h>
+
+static int bucket_of(const SpatialHash *hash, int cell_x, int cell_y)
+{
+    uint32_t h = (uint32_t)cell_x * 73856093u ^ (uint32_t)cell_y * 19349663u;
+    return (int)(h & (uint32_t)hash->bucket_mask);
+}
+
+static int cell_coord(const SpatialHash *hash, float value)
+{
+    return (int)floorf(value * hash->inv_cell_size);
+}
+
+SpatialHash *spatial_hash_create(float cell_size)
+{
+    SpatialHash *hash = (SpatialHash *)calloc(1, sizeof(SpatialHash));
+    if (!hash)
+        return NULL;
+    hash->cell_size = cell_size;
+    hash->inv_cell_size = 1.0f / cell_size;
+    return hash;
+}
+
+void spatial_hash_destroy(SpatialHash *hash)
+{
+    if (!hash)
+        return;
+    free(hash->bucket_start);
+    free(hash->index);
+    free(hash->x);
+    free(hash->y);
+    free(hash->cell_x);
+    free(hash->cell_y);
+    free(hash->entry_bucket);
+    free(hash);
+}
+
+static int grow(SpatialHash *hash, int count)
+{
+    if (count <= hash->capacity)
+        return 0;
+
+    int new_capacity = hash->capacity > 0 ? hash->capacity : 256;
+    while (new_capacity < count)
+        new_capacity *= 2;
+
+    // Twice as many buckets as entries keeps chains short
+    int buckets = SPATIAL_MIN_BUCKETS;
+    while (buckets < new_capacity * 2)
+        buckets *= 2;
+
+    int *grown_start = realloc(hash->bucket_start, sizeof(int) * (buckets + 1));
+    if (grown_start)
+        hash->bucket_start = grown_start;
+    int *grown_index = realloc(hash->index, sizeof(int) * new_capacity);
+    if (grown_index)
+        hash->index = grown_index;
+    float *grown_x = realloc(hash->x, sizeof(float) * new_capacity);
+    if (grown_x)
+        hash->x = grown_x;
+    float *grown_y = realloc(hash->y, sizeof(float) * new_capacity);
+    if (grown_y)
+        hash->y = grown_y;
+    int *grown_cell_x = realloc(hash->cell_x, sizeof(int) * new_capacity);
+    if (grown_cell_x)
+        hash->cell_x = grown_cell_x;
+    int *grown_cell_y = realloc(hash->cell_y, sizeof(int) * new_capacity);
+    if (grown_cell_y)
+        hash->cell_y = grown_cell_y;
+    int *grown_bucket = realloc(hash->entry_bucket, sizeof(int) * new_capacity);
+    if (grown_bucket)
+        hash->entry_bucket = grown_bucket;
+
+    if (!grown_start || !grown_index || !grown_x || !grown_y || !grown_cell_x || !grown_cell_y || !grown_bucket)
+    {
+        printf("Unable to grow spatial hash buffers!\n");
+        return -1;
+    }
+
+    hash->capacity = new_capacity;
+    hash->bucket_mask = buckets - 1;
+    return 0;
+}
+
+// Counting sort of all positions by bucket: count, prefix sum, scatter
+int spatial_hash_build(SpatialHash *hash, const float *x, const float *y, int count)
+{
+    hash->count = 0;
+    if (grow(hash, count) != 0)
+        return -1;
+    if (hash->capacity == 0)
+        return 0;
+
+    int buckets = hash->bucket_mask + 1;
+    memset(hash->bucket_start, 0, sizeof(int) * (buckets + 1));
+
+    for (int i = 0; i < count; i++)
+    {
+        int bucket = bucket_of(hash, cell_coord(hash, x[i]), cell_coord(hash, y[i]));
+        hash->entry_bucket[i] = bucket;
+        hash->bucket_start[bucket + 1]++;
+    }
+
+    for (int b = 0; b < buckets; b++)
+        hash->bucket_start[b + 1] += hash->bucket_start[b];
+
+    // bucket_start[b] walks forward while filling and ends at the old bucket_start[b + 1]
+    for (int i = 0; i < count; i++)
+    {
+        int slot = hash->bucket_start[hash->entry_bucket[i]]++;
+        hash->index[slot] = i;
+        hash->x[slot] = x[i];
+        hash->y[slot] = y[i];
+        hash->cell_x[slot] = cell_coord(hash, x[i]);
+        hash->cell_y[slot] = cell_coord(hash, y[i]);
+    }
+
+    // Shift back so bucket_start[b] is the first slot of bucket b again
+    for (int b = buckets; b > 0; b--)
+        hash->bucket_start[b] = hash->bucket_start[b - 1];
+    hash->bucket_start[0] = 0;
+
+    hash->count = count;
+    return 0;
+}
+
+// All points within radius of (x, y), written to out (up to max_out). Returns how many
+// were found, which can exceed max_out.
+int spatial_hash_query_radius(const SpatialHash *hash, float x, float y, float radius, int *out, int max_out)
+{
+    if (hash->count == 0)
+        return 0;
+
+    int min_cx = cell_coord(hash, x - radius);
+    int max_cx = cell_coord(hash, x + radius);
+    int min_cy = cell_coord(hash, y - radius);
+    int max_cy = cell_coord(hash, y + radius);
+    float radius_sq = radius * radius;
+    int found = 0;
+
+    for (int cy = min_cy; cy <= max_cy; cy++)
+    {
+        for (int cx = min_cx; cx <= max_cx; cx++)
+        {
+            int bucket = bucket_of(hash, cx, cy);
+            for (int slot = hash->bucket_start[bucket]; slot < hash->bucket_start[bucket + 1]; slot++)
+            {
+                if (hash->cell_x[slot] != cx || hash->cell_y[slot] != cy)
+                    continue;
+                float dx = hash->x[slot] - x;
+                float dy = hash->y[slot] - y;
+                if (dx * dx + dy * dy > radius_sq)
+                    continue;
+                if (found < max_out)
+                    out[found] = hash->index[slot];
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+// Closest point to (x, y) within max_radius, skipping index exclude (pass -1 to keep
+// all). Searches outward ring by ring and stops once no farther ring can do better.
+int spatial_hash_nearest(const SpatialHash *hash, float x, float y, float max_radius, int exclude)
+{
+    if (hash->count == 0)
+        return -1;
+
+    int center_x = cell_coord(hash, x);
+    int center_y = cell_coord(hash, y);
+    int max_ring = (int)ceilf(max_radius * hash->inv_cell_size);
+    float best_sq = max_radius * max_radius;
+    int best = -1;
+
+    for (int ring = 0; ring <= max_ring; ring++)
+    {
+        // Anything in this ring is at least (ring - 1) cells away
+        float ring_min = (ring - 1) * hash->cell_size;
+        if (ring > 1 && ring_min * ring_min > best_sq)
+            break;
+
+        for (int cy = center_y - ring; cy <= center_y + ring; cy++)
+        {
+            int edge_row = (cy == center_y - ring || cy == center_y + ring);
+            for (int cx = center_x - ring; cx <= center_x + ring; cx += (edge_row || ring == 0) ? 1 : 2 * ring)
+            {
+                int bucket = bucket_of(hash, cx, cy);
+                for (int slot = hash->bucket_start[bucket]; slot < hash->bucket_start[bucket + 1]; slot++)
+                {
+                    if (hash->cell_x[slot] != cx || hash->cell_y[slot] != cy || hash->index[slot] == exclude)
+                        continue;
+                    float dx = hash->x[slot] - x;
+                    float dy = hash->y[slot] - y;
+                    float dist_sq = dx * dx + dy * dy;
+                    if (dist_sq <= best_sq)
+                    {
+                        best_sq = dist_sq;
+                        best = hash->index[slot];
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+// Call fn once for every unordered pair closer than radius. Each point only looks at
+// cells at or after its own in scan order, so no pair is reported twice.
+void spatial_hash_for_each_pair(const SpatialHash *hash, float radius, SpatialPairFn fn, void *userdata)
+{
+    int reach = (int)ceilf(radius * hash->inv_cell_size);
+    float radius_sq = radius * radius;
+
+    for (int a = 0; a < hash->count; a++)
+    {
+        int acx = hash->cell_x[a];
+        int acy = hash->cell_y[a];
+
+        for (int cy = acy; cy <= acy + reach; cy++)
+        {
+            for (int cx = acx - reach; cx <= acx + reach; cx++)
+            {
+                if (cy == acy && cx < acx)
+                    continue;
+
+                int same_cell = (cx == acx && cy == acy);
+                int bucket = bucket_of(hash, cx, cy);
+                for (int b = hash->bucket_start[bucket]; b < hash->bucket_start[bucket + 1]; b++)
+                {
+                    if (hash->cell_x[b] != cx || hash->cell_y[b] != cy)
+                        continue;
+                    // Inside one cell, slot order breaks the tie
+                    if (same_cell && b <= a)
+                        continue;
+                    float dx = hash->x[b] - hash->x[a];
+                    float dy = hash->y[b] - hash->y[a];
+                    float dist_sq = dx * dx + dy * dy;
+                    if (dist_sq < radius_sq)
+                        fn(userdata, hash->index[a], hash->index[b], dist_sq);
+                }
+            }
+        }
+    }
+}
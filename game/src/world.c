@@ -0,0 +1,404 @@
+#include "world.h"
+#include "engine.h"
+#include "mapgen.h"
+#include "rng.h"
+#include <string.h>
+#include <math.h>
+
+// Generation reads this many extra noise tiles past each chunk edge: one per smoothing
+// iteration, so every chunk tile sees exactly the neighbourhood it would in an infinite
+// map and chunk boundaries line up for the same seed
+#define WORLD_SMOOTH_ITERATIONS 3
+#define WORLD_GEN_HALO WORLD_SMOOTH_ITERATIONS
+#define WORLD_SPAWN_CLEAR_RADIUS 3
+
+static int floor_div(int value, int divisor)
+{
+    int quotient = value / divisor;
+    if ((value % divisor != 0) && ((value < 0) != (divisor < 0)))
+        quotient--;
+    return quotient;
+}
+
+static int bucket_of(int chunk_x, int chunk_y)
+{
+    uint32_t hash = (uint32_t)chunk_x * 73856093u ^ (uint32_t)chunk_y * 19349663u;
+    return hash & (WORLD_BUCKETS - 1);
+}
+
+static int find_slot(World *world, int chunk_x, int chunk_y)
+{
+    for (int slot = world->buckets[bucket_of(chunk_x, chunk_y)]; slot >= 0; slot = world->chunks[slot].next)
+    {
+        if (world->chunks[slot].chunk_x == chunk_x && world->chunks[slot].chunk_y == chunk_y)
+            return slot;
+    }
+    return -1;
+}
+
+static void unlink_slot(World *world, int slot)
+{
+    WorldChunk *chunk = &world->chunks[slot];
+    int *link = &world->buckets[bucket_of(chunk->chunk_x, chunk->chunk_y)];
+    while (*link >= 0)
+    {
+        if (*link == slot)
+        {
+            *link = chunk->next;
+            break;
+        }
+        link = &world->chunks[*link].next;
+    }
+    chunk->next = -1;
+}
+
+static void generate_chunk(uint32_t seed, WorldChunk *chunk)
+{
+    int size = WORLD_CHUNK_SIZE + 2 * WORLD_GEN_HALO;
+    int origin_x = chunk->chunk_x * WORLD_CHUNK_SIZE - WORLD_GEN_HALO;
+    int origin_y = chunk->chunk_y * WORLD_CHUNK_SIZE - WORLD_GEN_HALO;
+
+    WallBitboard walls, scratch;
+    if (bitboard_init(&walls, size, size) != 0 || bitboard_init(&scratch, size, size) != 0)
+    {
+        printf("Unable to allocate chunk generation buffers!\n");
+        bitboard_free(&walls);
+        memset(chunk->cells, 0, sizeof(chunk->cells));
+        return;
+    }
+
+    // Noise keyed by world coordinates, same rule as generate_map
+    for (int y = 0; y < size; y++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            if (rng_range(rng_u32(seed, RNG_STREAM_MAP_NOISE, origin_x + x, origin_y + y), 100) < 35)
+                bitboard_set_wall(&walls, x, y);
+        }
+    }
+
+    // Each pass leaves one more ring at the edge unreliable; the halo absorbs them
+    for (int i = 0; i < WORLD_SMOOTH_ITERATIONS; i++)
+    {
+        bitboard_smooth_rows(&walls, &scratch, 0, size);
+        uint64_t *swap = walls.bits;
+        walls.bits = scratch.bits;
+        scratch.bits = swap;
+    }
+
+    for (int y = 0; y < WORLD_CHUNK_SIZE; y++)
+    {
+        for (int x = 0; x < WORLD_CHUNK_SIZE; x++)
+        {
+            int world_x = origin_x + WORLD_GEN_HALO + x;
+            int world_y = origin_y + WORLD_GEN_HALO + y;
+            int spawn = abs(world_x) <= WORLD_SPAWN_CLEAR_RADIUS && abs(world_y) <= WORLD_SPAWN_CLEAR_RADIUS;
+
+            Cell *cell = &chunk->cells[y * WORLD_CHUNK_SIZE + x];
+            if (!spawn && bitboard_is_wall(&walls, x + WORLD_GEN_HALO, y + WORLD_GEN_HALO))
+            {
+                cell->flags = 0;
+                cell->tile_type = TILE_WALL;
+            }
+            else
+            {
+                cell->flags = WALKABLE;
+                cell->tile_type = TILE_FLOOR;
+            }
+        }
+    }
+
+    bitboard_free(&walls);
+    bitboard_free(&scratch);
+}
+
+static int generator_main(void *data)
+{
+    World *world = (World *)data;
+
+    SDL_LockMutex(world->queue_mutex);
+    while (1)
+    {
+        while (world->queue_count == 0 && !world->stopping)
+            SDL_CondWait(world->queue_cond, world->queue_mutex);
+        if (world->stopping)
+            break;
+
+        int slot = world->queue[world->queue_head];
+        world->queue_head = (world->queue_head + 1) % WORLD_MAX_CHUNKS;
+        world->queue_count--;
+        SDL_UnlockMutex(world->queue_mutex);
+
+        WorldChunk *chunk = &world->chunks[slot];
+        generate_chunk(world->seed, chunk);
+        SDL_AtomicSet(&chunk->state, CHUNK_READY);
+
+        SDL_LockMutex(world->queue_mutex);
+    }
+    SDL_UnlockMutex(world->queue_mutex);
+    return 0;
+}
+
+World *world_create(uint32_t seed)
+{
+    World *world = (World *)calloc(1, sizeof(World));
+    if (!world)
+        return NULL;
+
+    world->chunks = (WorldChunk *)calloc(WORLD_MAX_CHUNKS, sizeof(WorldChunk));
+    if (!world->chunks)
+    {
+        free(world);
+        return NULL;
+    }
+
+    world->seed = seed;
+    for (int i = 0; i < WORLD_BUCKETS; i++)
+        world->buckets[i] = -1;
+    for (int i = 0; i < WORLD_MAX_CHUNKS; i++)
+    {
+        world->chunks[i].next = -1;
+        SDL_AtomicSet(&world->chunks[i].state, CHUNK_EMPTY);
+    }
+
+    world->queue_mutex = SDL_CreateMutex();
+    world->queue_cond = SDL_CreateCond();
+    for (int i = 0; i < WORLD_GEN_THREADS; i++)
+    {
+        world->threads[world->thread_count] = SDL_CreateThread(generator_main, "world_gen", world);
+        if (!world->threads[world->thread_count])
+        {
+            printf("Unable to start world generation thread! SDL Error: %s\n", SDL_GetError());
+            break;
+        }
+        world->thread_count++;
+    }
+
+    return world;
+}
+
+void world_destroy(World *world)
+{
+    if (!world)
+        return;
+
+    SDL_LockMutex(world->queue_mutex);
+    world->stopping = 1;
+    SDL_CondBroadcast(world->queue_cond);
+    SDL_UnlockMutex(world->queue_mutex);
+
+    for (int i = 0; i < world->thread_count; i++)
+    {
+        SDL_WaitThread(world->threads[i], NULL);
+    }
+
+    SDL_DestroyCond(world->queue_cond);
+    SDL_DestroyMutex(world->queue_mutex);
+    free(world->chunks);
+    free(world);
+}
+
+// Pick a slot for a new chunk: a free one, else the least recently used ready chunk
+// that isn't needed this frame. Returns -1 if every slot is busy.
+static int claim_slot(World *world)
+{
+    int best = -1;
+    for (int i = 0; i < WORLD_MAX_CHUNKS; i++)
+    {
+        WorldChunk *chunk = &world->chunks[i];
+        int state = SDL_AtomicGet(&chunk->state);
+        if (state == CHUNK_EMPTY)
+            return i;
+        if (state != CHUNK_READY || chunk->last_used == world->frame)
+            continue;
+        if (best < 0 || chunk->last_used < world->chunks[best].last_used)
+            best = i;
+    }
+
+    if (best >= 0)
+        unlink_slot(world, best);
+    return best;
+}
+
+static void request_chunk(World *world, int chunk_x, int chunk_y)
+{
+    int slot = find_slot(world, chunk_x, chunk_y);
+    if (slot >= 0)
+    {
+        world->chunks[slot].last_used = world->frame;
+        return;
+    }
+
+    slot = claim_slot(world);
+    if (slot < 0)
+        return;
+
+    WorldChunk *chunk = &world->chunks[slot];
+    chunk->chunk_x = chunk_x;
+    chunk->chunk_y = chunk_y;
+    chunk->last_used = world->frame;
+    int bucket = bucket_of(chunk_x, chunk_y);
+    chunk->next = world->buckets[bucket];
+    world->buckets[bucket] = slot;
+
+    if (world->thread_count == 0)
+    {
+        // No generator threads, build it right here
+        generate_chunk(world->seed, chunk);
+        SDL_AtomicSet(&chunk->state, CHUNK_READY);
+        return;
+    }
+
+    SDL_AtomicSet(&chunk->state, CHUNK_QUEUED);
+    SDL_LockMutex(world->queue_mutex);
+    world->queue[(world->queue_head + world->queue_count) % WORLD_MAX_CHUNKS] = slot;
+    world->queue_count++;
+    SDL_CondSignal(world->queue_cond);
+    SDL_UnlockMutex(world->queue_mutex);
+}
+
+// Keep the chunks around a world-space point (pixels) resident, nearest rings first
+void world_update(World *world, float focus_x, float focus_y)
+{
+    world->frame++;
+
+    int center_x = floor_div((int)floorf(focus_x / TILE_SIZE), WORLD_CHUNK_SIZE);
+    int center_y = floor_div((int)floorf(focus_y / TILE_SIZE), WORLD_CHUNK_SIZE);
+
+    for (int ring = 0; ring <= WORLD_LOAD_RADIUS; ring++)
+    {
+        for (int dy = -ring; dy <= ring; dy++)
+        {
+            for (int dx = -ring; dx <= ring; dx++)
+            {
+                if (abs(dx) != ring && abs(dy) != ring)
+                    continue;
+                request_chunk(world, center_x + dx, center_y + dy);
+            }
+        }
+    }
+}
+
+// Chunk-aware get_cell: NULL while the chunk isn't generated yet. Read-only, since
+// generator threads own chunk cells until they are ready.
+const Cell *world_get_cell(World *world, int x, int y)
+{
+    int chunk_x = floor_div(x, WORLD_CHUNK_SIZE);
+    int chunk_y = floor_div(y, WORLD_CHUNK_SIZE);
+
+    int slot = find_slot(world, chunk_x, chunk_y);
+    if (slot < 0)
+        return NULL;
+
+    WorldChunk *chunk = &world->chunks[slot];
+    if (SDL_AtomicGet(&chunk->state) != CHUNK_READY)
+        return NULL;
+
+    int local_x = x - chunk_x * WORLD_CHUNK_SIZE;
+    int local_y = y - chunk_y * WORLD_CHUNK_SIZE;
+    return &chunk->cells[local_y * WORLD_CHUNK_SIZE + local_x];
+}
+
+// Chunk-aware is_walkable: tiles in chunks that aren't ready block movement
+int world_is_walkable(World *world, int x, int y)
+{
+    const Cell *cell = world_get_cell(world, x, y);
+    return cell ? is_walkable(cell) : 0;
+}
+
+// The view's map is the chunks around the one holding world tile (tile_x, tile_y);
+// everything starts as wall until world_view_update copies generated chunks in
+int world_view_init(WorldView *view, int tile_x, int tile_y)
+{
+    memset(view, 0, sizeof(WorldView));
+    view->map = create_map(WORLD_VIEW_TILES, WORLD_VIEW_TILES);
+    if (!view->map)
+        return -1;
+
+    view->center_x = floor_div(tile_x, WORLD_CHUNK_SIZE);
+    view->center_y = floor_div(tile_y, WORLD_CHUNK_SIZE);
+    view->origin_x = (view->center_x - WORLD_LOAD_RADIUS) * WORLD_CHUNK_SIZE;
+    view->origin_y = (view->center_y - WORLD_LOAD_RADIUS) * WORLD_CHUNK_SIZE;
+    for (int y = 0; y < WORLD_VIEW_TILES; y++)
+    {
+        for (int x = 0; x < WORLD_VIEW_TILES; x++)
+            set_cell(view->map, x, y, 0, TILE_WALL);
+    }
+    return 0;
+}
+
+void world_view_free(WorldView *view)
+{
+    cleanup_map(view->map);
+    view->map = NULL;
+}
+
+static void copy_chunk(WorldView *view, const WorldChunk *chunk, int view_x, int view_y)
+{
+    int base_x = view_x * WORLD_CHUNK_SIZE;
+    int base_y = view_y * WORLD_CHUNK_SIZE;
+    for (int y = 0; y < WORLD_CHUNK_SIZE; y++)
+    {
+        for (int x = 0; x < WORLD_CHUNK_SIZE; x++)
+        {
+            const Cell *cell = &chunk->cells[y * WORLD_CHUNK_SIZE + x];
+            set_cell(view->map, base_x + x, base_y + y, cell->flags, cell->tile_type);
+        }
+    }
+}
+
+// Stream chunks around a point given in view pixels and keep the view on them. Once
+// the point leaves the centre chunk the view moves with it, and *shift_x, *shift_y
+// say how many tiles every position in view coordinates must move by. Returns a mix
+// of WORLD_VIEW_MOVED and WORLD_VIEW_FILLED, 0 when the map didn't change.
+int world_view_update(WorldView *view, World *world, float focus_x, float focus_y, int *shift_x, int *shift_y)
+{
+    int tile_x = view->origin_x + (int)floorf(focus_x / TILE_SIZE);
+    int tile_y = view->origin_y + (int)floorf(focus_y / TILE_SIZE);
+    world_update(world, tile_x * (float)TILE_SIZE, tile_y * (float)TILE_SIZE);
+
+    int result = 0;
+    *shift_x = 0;
+    *shift_y = 0;
+    int center_x = floor_div(tile_x, WORLD_CHUNK_SIZE);
+    int center_y = floor_div(tile_y, WORLD_CHUNK_SIZE);
+    if (center_x != view->center_x || center_y != view->center_y)
+    {
+        *shift_x = (view->center_x - center_x) * WORLD_CHUNK_SIZE;
+        *shift_y = (view->center_y - center_y) * WORLD_CHUNK_SIZE;
+        view->center_x = center_x;
+        view->center_y = center_y;
+        view->origin_x = (center_x - WORLD_LOAD_RADIUS) * WORLD_CHUNK_SIZE;
+        view->origin_y = (center_y - WORLD_LOAD_RADIUS) * WORLD_CHUNK_SIZE;
+
+        // Chunks still resident are copied straight back below
+        for (int y = 0; y < WORLD_VIEW_TILES; y++)
+        {
+            for (int x = 0; x < WORLD_VIEW_TILES; x++)
+                set_cell(view->map, x, y, 0, TILE_WALL);
+        }
+        memset(view->filled, 0, sizeof(view->filled));
+        view->filled_count = 0;
+        result |= WORLD_VIEW_MOVED;
+    }
+
+    for (int view_y = 0; view_y < WORLD_VIEW_CHUNKS; view_y++)
+    {
+        for (int view_x = 0; view_x < WORLD_VIEW_CHUNKS; view_x++)
+        {
+            uint8_t *filled = &view->filled[view_y * WORLD_VIEW_CHUNKS + view_x];
+            if (*filled)
+                continue;
+
+            int slot = find_slot(world, center_x - WORLD_LOAD_RADIUS + view_x, center_y - WORLD_LOAD_RADIUS + view_y);
+            if (slot < 0 || SDL_AtomicGet(&world->chunks[slot].state) != CHUNK_READY)
+                continue;
+
+            copy_chunk(view, &world->chunks[slot], view_x, view_y);
+            *filled = 1;
+            view->filled_count++;
+            result |= WORLD_VIEW_FILLED;
+        }
+    }
+    return result;
+}